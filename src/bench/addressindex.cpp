@@ -0,0 +1,55 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+
+#include <index/addressindex.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <validation.h>
+
+namespace {
+struct TestBlockAndUndo {
+    const BasicTestingSetup test_setup{CBaseChainParams::MAIN, {"-nodebuglogfile", "-nodebug"}};
+    CBlock block{};
+    CBlockUndo block_undo{};
+
+    TestBlockAndUndo()
+    {
+        CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
+        char a = '\0';
+        stream.write(&a, 1); // Prevent compaction
+
+        stream >> block;
+
+        // Give every spent output its own P2WPKH script, as in a block spending from many wallets.
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            CTxUndo tx_undo;
+            for (const CTxIn& txin : block.vtx[i]->vin) {
+                uint160 key_id;
+                std::copy(txin.prevout.hash.begin(), txin.prevout.hash.begin() + key_id.size(), key_id.begin());
+                CScript script = GetScriptForDestination(WitnessV0KeyHash(key_id));
+                tx_undo.vprevout.emplace_back(CTxOut(COIN, script), 413566, false, false);
+            }
+            block_undo.vtxundo.push_back(std::move(tx_undo));
+        }
+    }
+};
+} // namespace
+
+static void AddressIndexBlock(benchmark::Bench& bench)
+{
+    TestBlockAndUndo data;
+    AddressIndex index(8 << 20, /* f_memory */ true);
+
+    bench.unit("block").run([&] {
+        bool indexed = index.IndexBlock(data.block, data.block_undo, 413567);
+        assert(indexed);
+    });
+}
+
+BENCHMARK(AddressIndexBlock);
@@ -0,0 +1,55 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <vector>
+
+static void BlockIndexLoad(benchmark::Bench& bench)
+{
+    const BasicTestingSetup test_setup{CBaseChainParams::MAIN, {"-nodebuglogfile", "-nodebug"}};
+
+    // A chain of 200k blocks, the last quarter of which has MWEB data
+    constexpr int NUM_BLOCKS{200000};
+    std::vector<uint256> hashes(NUM_BLOCKS);
+    std::vector<CBlockIndex> entries(NUM_BLOCKS);
+    std::vector<const CBlockIndex*> blockinfo;
+    FastRandomContext rand(true);
+    for (int i = 0; i < NUM_BLOCKS; ++i) {
+        CBlockIndex& entry = entries[i];
+        entry.pprev = i > 0 ? &entries[i - 1] : nullptr;
+        entry.nHeight = i;
+        entry.nTime = 1317972665 + i * 150;
+        entry.nBits = 0x1e0ffff0;
+        entry.nNonce = rand.rand32();
+        hashes[i] = entry.GetBlockHeader().GetHash();
+        entry.phashBlock = &hashes[i];
+        entry.nTx = 1;
+        entry.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+        if (i >= NUM_BLOCKS * 3 / 4) {
+            entry.nStatus |= BLOCK_HAVE_MWEB;
+            entry.mweb_header = std::make_shared<mw::Header>(i, mw::Hash(rand.rand256().begin()), mw::Hash(rand.rand256().begin()),
+                mw::Hash(rand.rand256().begin()), BlindingFactor(rand.rand256().begin()), BlindingFactor(rand.rand256().begin()), i, i);
+        }
+        blockinfo.push_back(&entry);
+    }
+
+    CBlockTreeDB blocktree(64 << 20, /* fMemory */ true);
+    assert(blocktree.WriteBatchSync({}, 0, blockinfo));
+
+    bench.batch(NUM_BLOCKS).unit("block").run([&] {
+        LOCK(cs_main);
+        BlockManager blockman;
+        std::set<CBlockIndex*, CBlockIndexWorkComparator> candidates;
+        assert(blockman.LoadBlockIndex(Params().GetConsensus(), blocktree, candidates));
+        pindexBestHeader = nullptr;
+    });
+}
+
+BENCHMARK(BlockIndexLoad);
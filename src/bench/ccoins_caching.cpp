@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
 
@@ -51,4 +52,76 @@ static void CCoinsCaching(benchmark::Bench& bench)
     ECC_Stop();
 }
 
+namespace {
+//! Discards everything flushed to it, so only the cost of the cache itself is measured.
+class CCoinsViewDiscard : public CCoinsView
+{
+public:
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const mw::CoinsViewCache::Ptr& derivedView, bool erase) override
+    {
+        if (erase) mapCoins.clear();
+        return true;
+    }
+};
+
+std::vector<COutPoint> RandomOutPoints(FastRandomContext& rng, size_t count)
+{
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        outpoints.emplace_back(rng.rand256(), rng.randrange(4));
+    }
+    return outpoints;
+}
+
+Coin DummyCoin()
+{
+    CScript script;
+    script << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0) << OP_EQUALVERIFY << OP_CHECKSIG;
+    return Coin(CTxOut(COIN, script), 1, false, false);
+}
+} // namespace
+
+// Random lookups in a cache holding a large number of coins, as during IBD with a large -dbcache.
+static void CCoinsCachingLargeLookup(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/* deterministic */ true);
+    CCoinsViewDiscard base;
+    CCoinsViewCache cache(&base);
+
+    const std::vector<COutPoint> outpoints = RandomOutPoints(rng, 1000000);
+    const Coin coin = DummyCoin();
+    for (const COutPoint& outpoint : outpoints) {
+        cache.AddCoin(outpoint, Coin(coin), false);
+    }
+
+    size_t i = 0;
+    bench.unit("lookup").run([&] {
+        const Coin& found = cache.AccessCoin(outpoints[i]);
+        assert(!found.IsSpent());
+        i = (i + 7919) % outpoints.size();
+    });
+}
+
+// Filling the cache and flushing it, which frees every entry.
+static void CCoinsCachingLargeFlush(benchmark::Bench& bench)
+{
+    FastRandomContext rng(/* deterministic */ true);
+    CCoinsViewDiscard base;
+    CCoinsViewCache cache(&base);
+
+    const std::vector<COutPoint> outpoints = RandomOutPoints(rng, 100000);
+    const Coin coin = DummyCoin();
+
+    bench.batch(outpoints.size()).unit("coin").run([&] {
+        for (const COutPoint& outpoint : outpoints) {
+            cache.AddCoin(outpoint, Coin(coin), false);
+        }
+        bool success = cache.Flush();
+        assert(success);
+    });
+}
+
 BENCHMARK(CCoinsCaching);
+BENCHMARK(CCoinsCachingLargeLookup);
+BENCHMARK(CCoinsCachingLargeFlush);
@@ -4,10 +4,13 @@
 
 #include <bench/bench.h>
 #include <checkqueue.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
 #include <random.h>
+#include <tinyformat.h>
+#include <uint256.h>
 #include <util/system.h>
 
 #include <boost/thread/thread.hpp>
@@ -75,3 +78,52 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     ECC_Stop();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+
+// This Benchmark tests how the CheckQueue scales with the number of threads,
+// for checks that take a few microseconds each, like script checks. Thread
+// counts beyond the number of cores are skipped.
+static void CCheckQueueScaling(benchmark::Bench& bench)
+{
+    struct HashJob {
+        uint256 hash;
+        HashJob() {}
+        explicit HashJob(FastRandomContext& insecure_rand) : hash(insecure_rand.rand256()) {}
+        bool operator()()
+        {
+            uint256 result = hash;
+            for (int i = 0; i < 20; ++i) {
+                CSHA256().Write(result.begin(), result.size()).Finalize(result.begin());
+            }
+            return !result.IsNull();
+        }
+        void swap(HashJob& x) { std::swap(hash, x.hash); }
+    };
+
+    FastRandomContext insecure_rand(true);
+    std::vector<std::vector<HashJob>> vBatches(BATCHES);
+    for (auto& vChecks : vBatches) {
+        vChecks.reserve(BATCH_SIZE);
+        for (size_t x = 0; x < BATCH_SIZE; ++x)
+            vChecks.emplace_back(insecure_rand);
+    }
+
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        if (threads > GetNumCores()) break;
+
+        CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE};
+        boost::thread_group tg;
+        for (auto x = 0; x < threads - 1; ++x) {
+            tg.create_thread([&]{queue.Thread();});
+        }
+        bench.batch(BATCH_SIZE * BATCHES).unit("job").run(strprintf("CCheckQueueScaling/%d threads", threads), [&] {
+            CCheckQueueControl<HashJob> control(&queue);
+            for (auto vChecks : vBatches) {
+                control.Add(vChecks);
+            }
+            control.Wait();
+        });
+        tg.interrupt_all();
+        tg.join_all();
+    }
+}
+BENCHMARK(CCheckQueueScaling);
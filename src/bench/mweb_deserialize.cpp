@@ -0,0 +1,47 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <mw/models/tx/Kernel.h>
+#include <mw/models/tx/Output.h>
+#include <mw/models/wallet/StealthAddress.h>
+#include <streams.h>
+#include <version.h>
+
+// Deserializing (and hashing) the components of an MWEB block is on the critical path
+// of block relay, so keep an eye on the per-object cost.
+
+static constexpr size_t NUM_OBJECTS = 1000;
+
+template <typename T>
+static void DeserializeMWEB(benchmark::Bench& bench, const T& obj)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << std::vector<T>(NUM_OBJECTS, obj);
+    const size_t size = stream.size();
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    bench.batch(NUM_OBJECTS).unit("object").run([&] {
+        std::vector<T> objs;
+        stream >> objs;
+        bool rewound = stream.Rewind(size);
+        assert(rewound);
+    });
+}
+
+static void DeserializeMWEBOutputs(benchmark::Bench& bench)
+{
+    BlindingFactor blind;
+    DeserializeMWEB(bench, Output::Create(&blind, SecretKey::Random(), StealthAddress::Random(), 1'000'000));
+}
+
+static void DeserializeMWEBKernels(benchmark::Bench& bench)
+{
+    DeserializeMWEB(bench, Kernel::Create(BlindingFactor::Random(), SecretKey::Random(), 1'000, boost::none, std::vector<PegOutCoin>{}, boost::none));
+}
+
+BENCHMARK(DeserializeMWEBOutputs);
+BENCHMARK(DeserializeMWEBKernels);
@@ -0,0 +1,73 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <mw/models/block/Block.h>
+#include <mw/models/tx/Output.h>
+#include <mw/models/wallet/StealthAddress.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <test/util/setup_common.h>
+#include <version.h>
+
+#include <algorithm>
+#include <cassert>
+
+// Receiving a block with a full MWEB extension block, from the bytes read off the
+// socket to the deserialized block, as the socket and message handler threads do.
+
+static void ReceiveMWEBBlockMessage(benchmark::Bench& bench)
+{
+    const BasicTestingSetup test_setup{CBaseChainParams::MAIN, {"-nodebuglogfile", "-nodebug"}};
+
+    // Fill the block up to the protocol's message size limit with copies of one output
+    BlindingFactor blind;
+    const Output output = Output::Create(&blind, SecretKey::Random(), StealthAddress::Random(), 1'000'000);
+    const size_t num_outputs = (MAX_PROTOCOL_MESSAGE_LENGTH - 1000) / ::GetSerializeSize(output, PROTOCOL_VERSION);
+    auto mweb_header = std::make_shared<mw::Header>(1, mw::Hash(), mw::Hash(), mw::Hash(), BlindingFactor(), BlindingFactor(), num_outputs, 0);
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    CMutableTransaction hogex;
+    hogex.m_hogEx = true;
+    hogex.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(hogex));
+    block.mweb_block = MWEB::Block(std::make_shared<mw::Block>(mweb_header, TxBody({}, std::vector<Output>(num_outputs, output), {})));
+
+    CSerializedNetMsg msg = CNetMsgMaker(PROTOCOL_VERSION).Make(NetMsgType::BLOCK, block);
+    std::vector<unsigned char> wire;
+    V1TransportSerializer().prepareForTransport(msg, wire);
+    wire.insert(wire.end(), msg.data.begin(), msg.data.end());
+    assert(wire.size() <= MAX_PROTOCOL_MESSAGE_LENGTH + CMessageHeader::HEADER_SIZE);
+
+    V1TransportDeserializer deserializer(Params(), 0, SER_NETWORK, INIT_PROTO_VERSION);
+    deserializer.SetVersion(PROTOCOL_VERSION);
+    bench.unit("message").run([&] {
+        // Hand over the bytes in chunks the size of the socket handler's receive buffer
+        const char* pch = reinterpret_cast<const char*>(wire.data());
+        size_t remaining = wire.size();
+        while (remaining > 0) {
+            const int handled = deserializer.Read(pch, std::min<size_t>(remaining, 0x10000));
+            assert(handled > 0);
+            pch += handled;
+            remaining -= handled;
+        }
+        assert(deserializer.Complete());
+
+        uint32_t out_err_raw_size{0};
+        Optional<CNetMessage> received = deserializer.GetMessage(std::chrono::microseconds{0}, out_err_raw_size);
+        assert(received);
+        CBlock received_block;
+        received->m_recv >> received_block;
+        assert(received_block.mweb_block.m_block->GetOutputs().size() == num_outputs);
+    });
+}
+
+BENCHMARK(ReceiveMWEBBlockMessage);
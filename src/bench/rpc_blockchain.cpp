@@ -6,28 +6,65 @@
 #include <bench/data.h>
 
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <streams.h>
+#include <test/util/setup_common.h>
 #include <validation.h>
 
 #include <univalue.h>
 
+namespace {
+struct TestBlockAndIndex {
+    const BasicTestingSetup test_setup{CBaseChainParams::MAIN, {"-nodebuglogfile", "-nodebug"}};
+    CBlock block{};
+    uint256 blockHash{};
+    CBlockIndex blockindex{};
+
+    TestBlockAndIndex()
+    {
+        CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
+        char a = '\0';
+        stream.write(&a, 1); // Prevent compaction
+
+        stream >> block;
+
+        blockHash = block.GetHash();
+        blockindex.phashBlock = &blockHash;
+        blockindex.nBits = 403014710;
+    }
+};
+} // namespace
+
 static void BlockToJsonVerbose(benchmark::Bench& bench)
 {
-    CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
-    char a = '\0';
-    stream.write(&a, 1); // Prevent compaction
-
-    CBlock block;
-    stream >> block;
+    TestBlockAndIndex data;
+    bench.run([&] {
+        (void)blockToJSON(data.block, &data.blockindex, &data.blockindex, /*verbose*/ true);
+    });
+}
 
-    CBlockIndex blockindex;
-    const uint256 blockHash = block.GetHash();
-    blockindex.phashBlock = &blockHash;
-    blockindex.nBits = 403014710;
+static void BlockToJsonVerboseWrite(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
+    bench.run([&] {
+        auto univalue = blockToJSON(data.block, &data.blockindex, &data.blockindex, /*verbose*/ true);
+        auto str = univalue.write();
+        ankerl::nanobench::doNotOptimizeAway(str);
+    });
+}
 
+static void BlockToJsonVerboseStream(benchmark::Bench& bench)
+{
+    TestBlockAndIndex data;
     bench.run([&] {
-        (void)blockToJSON(block, &blockindex, &blockindex, /*verbose*/ true);
+        size_t size = 0;
+        JSONStreamWriter writer([&size](std::string&& chunk) { size += chunk.size(); });
+        blockToJSON(writer, data.block, &data.blockindex, &data.blockindex, /*verbose*/ true);
+        writer.Flush();
+        ankerl::nanobench::doNotOptimizeAway(size);
     });
 }
 
 BENCHMARK(BlockToJsonVerbose);
+BENCHMARK(BlockToJsonVerboseWrite);
+BENCHMARK(BlockToJsonVerboseStream);
@@ -14,6 +14,10 @@
 #include <validation.h>
 #include <util/system.h>
 
+#include <mw/consensus/Params.h>
+#include <mw/consensus/StealthSumValidator.h>
+#include <mw/mmr/MMR.h>
+
 #include <unordered_map>
 
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID) :
@@ -34,6 +38,24 @@ CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool f
             shorttxids.push_back(GetShortID(fUseWTXID ? tx.GetWitnessHash() : tx.GetHash()));
         }
     }
+
+    // MWEB: Short IDs for peers that can rebuild the extension block from their mempool
+    if (!mweb_block.IsNull()) {
+        const mw::Block::CPtr& pMWEB = mweb_block.m_block;
+        mweb_compact.header = pMWEB->GetHeader();
+        mweb_compact.input_shortids.reserve(pMWEB->GetInputs().size());
+        for (const Input& input : pMWEB->GetInputs()) {
+            mweb_compact.input_shortids.push_back(GetShortID(input.GetHash()));
+        }
+        mweb_compact.output_shortids.reserve(pMWEB->GetOutputs().size());
+        for (const Output& output : pMWEB->GetOutputs()) {
+            mweb_compact.output_shortids.push_back(GetShortID(output.GetHash()));
+        }
+        mweb_compact.kernel_shortids.reserve(pMWEB->GetKernels().size());
+        for (const Kernel& kernel : pMWEB->GetKernels()) {
+            mweb_compact.kernel_shortids.push_back(GetShortID(kernel.GetHash()));
+        }
+    }
 }
 
 void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
@@ -52,6 +74,47 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const mw::Hash& hash) const {
+    return GetShortID(uint256(hash.vec()));
+}
+
+// Builds a map of short IDs -> positions, returning false on a short ID collision
+// or a suspiciously uneven distribution (see PartiallyDownloadedBlock::InitData).
+static bool IndexShortIDs(const std::vector<uint64_t>& shortids, std::unordered_map<uint64_t, uint32_t>& positions)
+{
+    positions.reserve(shortids.size());
+    for (size_t i = 0; i < shortids.size(); i++) {
+        positions[shortids[i]] = i;
+        if (positions.bucket_size(positions.bucket(shortids[i])) > 12)
+            return false;
+    }
+    return positions.size() == shortids.size();
+}
+
+// MWEB: Fills in the positions of the compact extension block that match the given components.
+// If two different components match the same short ID, we just request it instead.
+template <typename T>
+static void MatchMWEBComponents(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<T>& components,
+                                const std::unordered_map<uint64_t, uint32_t>& positions,
+                                std::vector<boost::optional<T>>& available, std::vector<bool>& have, size_t& count)
+{
+    for (const T& component : components) {
+        auto idit = positions.find(cmpctblock.GetShortID(component.GetHash()));
+        if (idit == positions.end()) {
+            continue;
+        }
+
+        if (!have[idit->second]) {
+            available[idit->second] = component;
+            have[idit->second] = true;
+            count++;
+        } else if (available[idit->second] && available[idit->second]->GetHash() != component.GetHash()) {
+            available[idit->second] = boost::none;
+            count--;
+        }
+    }
+}
+
 
 
 ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
@@ -171,18 +234,150 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
             break;
     }
 
+    if (!cmpctblock.mweb_compact.IsNull()) {
+        ReadStatus mweb_status = InitMWEBData(cmpctblock, extra_txn);
+        if (mweb_status != READ_STATUS_OK)
+            return mweb_status;
+    }
+
     LogPrint(BCLog::CMPCTBLOCK, "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu\n", cmpctblock.header.GetHash().ToString(), GetSerializeSize(cmpctblock, PROTOCOL_VERSION));
 
     return READ_STATUS_OK;
 }
 
+ReadStatus PartiallyDownloadedBlock::InitMWEBData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
+    const CompactMWEBBlock& compact = cmpctblock.mweb_compact;
+    if (compact.input_shortids.size() > mw::MAX_NUM_INPUTS ||
+            compact.output_shortids.size() > mw::MAX_BLOCK_WEIGHT / mw::BASE_OUTPUT_WEIGHT ||
+            compact.kernel_shortids.size() > mw::MAX_BLOCK_WEIGHT / mw::BASE_KERNEL_WEIGHT)
+        return READ_STATUS_INVALID;
+    if (compact.kernel_shortids.size() != compact.header->GetNumKernels())
+        return READ_STATUS_INVALID;
+
+    assert(mweb_header == nullptr);
+    mweb_header = compact.header;
+    mweb_inputs_available.resize(compact.input_shortids.size());
+    mweb_outputs_available.resize(compact.output_shortids.size());
+    mweb_kernels_available.resize(compact.kernel_shortids.size());
+
+    std::unordered_map<uint64_t, uint32_t> input_positions, output_positions, kernel_positions;
+    if (!IndexShortIDs(compact.input_shortids, input_positions) ||
+            !IndexShortIDs(compact.output_shortids, output_positions) ||
+            !IndexShortIDs(compact.kernel_shortids, kernel_positions))
+        return READ_STATUS_FAILED; // Short ID collision
+
+    std::vector<bool> have_inputs(mweb_inputs_available.size());
+    std::vector<bool> have_outputs(mweb_outputs_available.size());
+    std::vector<bool> have_kernels(mweb_kernels_available.size());
+    auto match_tx = [&](const CTransaction& tx) {
+        const mw::Transaction::CPtr& pTx = tx.mweb_tx.m_transaction;
+        MatchMWEBComponents(cmpctblock, pTx->GetInputs(), input_positions, mweb_inputs_available, have_inputs, mweb_mempool_count);
+        MatchMWEBComponents(cmpctblock, pTx->GetOutputs(), output_positions, mweb_outputs_available, have_outputs, mweb_mempool_count);
+        MatchMWEBComponents(cmpctblock, pTx->GetKernels(), kernel_positions, mweb_kernels_available, have_kernels, mweb_mempool_count);
+    };
+
+    {
+    LOCK(pool->cs);
+    for (size_t i = 0; i < pool->vTxHashes.size(); i++) {
+        const CTransaction& tx = pool->vTxHashes[i].second->GetTx();
+        if (tx.HasMWEBTx()) {
+            match_tx(tx);
+        }
+    }
+    }
+
+    for (size_t i = 0; i < extra_txn.size(); i++) {
+        if (extra_txn[i].second && extra_txn[i].second->HasMWEBTx()) {
+            match_tx(*extra_txn[i].second);
+        }
+    }
+
+    return READ_STATUS_OK;
+}
+
 bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const {
     assert(!header.IsNull());
     assert(index < txn_available.size());
     return txn_available[index] != nullptr;
 }
 
-ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing) {
+void PartiallyDownloadedBlock::GetMissingMWEBIndexes(BlockTransactionsRequest& req) const {
+    for (size_t i = 0; i < mweb_inputs_available.size(); i++) {
+        if (!mweb_inputs_available[i])
+            req.mweb_input_indexes.push_back(i);
+    }
+    for (size_t i = 0; i < mweb_outputs_available.size(); i++) {
+        if (!mweb_outputs_available[i])
+            req.mweb_output_indexes.push_back(i);
+    }
+    for (size_t i = 0; i < mweb_kernels_available.size(); i++) {
+        if (!mweb_kernels_available[i])
+            req.mweb_kernel_indexes.push_back(i);
+    }
+}
+
+ReadStatus PartiallyDownloadedBlock::FillMWEBBlock(CBlock& block, const std::vector<Input>& inputs_missing, const std::vector<Output>& outputs_missing, const std::vector<Kernel>& kernels_missing) {
+    // Merges what we found locally with what the peer sent us, in block order.
+    auto fill = [](auto& available, const auto& missing, auto& components) -> bool {
+        size_t missing_offset = 0;
+        components.reserve(available.size());
+        for (auto& component : available) {
+            if (!component) {
+                if (missing.size() <= missing_offset)
+                    return false;
+                components.push_back(missing[missing_offset++]);
+            } else {
+                components.push_back(std::move(*component));
+            }
+        }
+        return missing.size() == missing_offset;
+    };
+
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<Kernel> kernels;
+    if (!fill(mweb_inputs_available, inputs_missing, inputs) ||
+            !fill(mweb_outputs_available, outputs_missing, outputs) ||
+            !fill(mweb_kernels_available, kernels_missing, kernels))
+        return READ_STATUS_INVALID;
+
+    auto pMWEB = std::make_shared<mw::Block>(mweb_header, TxBody(std::move(inputs), std::move(outputs), std::move(kernels)));
+
+    // A short ID collision would leave us with the wrong components. The header commits to the
+    // kernels and the stealth offset, so check those here.
+    MemMMR kernel_mmr;
+    for (const Kernel& kernel : pMWEB->GetKernels()) {
+        kernel_mmr.Add(kernel);
+    }
+    if (kernel_mmr.Root() != mweb_header->GetKernelRoot())
+        return READ_STATUS_FAILED;
+
+    try {
+        StealthSumValidator::Validate(mweb_header->GetStealthOffset(), pMWEB->GetTxBody());
+    } catch (const std::exception&) {
+        return READ_STATUS_FAILED;
+    }
+
+    // The header also commits to the output MMR and leafset, which follow from the parent's.
+    // Applying the block to a throwaway cache of the parent's view checks the output root and
+    // count, and that every input spends an unspent output.
+    if (mweb_view != nullptr) {
+        try {
+            mw::CoinsViewCache view(mweb_view);
+            view.ApplyBlock(pMWEB);
+        } catch (const std::exception&) {
+            return READ_STATUS_FAILED;
+        }
+    }
+
+    block.mweb_block = MWEB::Block(pMWEB);
+    return READ_STATUS_OK;
+}
+
+ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing,
+                                               const std::vector<Input>& mweb_inputs_missing,
+                                               const std::vector<Output>& mweb_outputs_missing,
+                                               const std::vector<Kernel>& mweb_kernels_missing) {
     assert(!header.IsNull());
     uint256 hash = header.GetHash();
     block = header;
@@ -206,6 +401,23 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
     if (vtx_missing.size() != tx_missing_offset)
         return READ_STATUS_INVALID;
 
+    const size_t mweb_missing_count = mweb_inputs_missing.size() + mweb_outputs_missing.size() + mweb_kernels_missing.size();
+    if (mweb_header != nullptr) {
+        ReadStatus mweb_status = FillMWEBBlock(block, mweb_inputs_missing, mweb_outputs_missing, mweb_kernels_missing);
+
+        // Make sure we can't call FillMWEBBlock again.
+        mweb_header.reset();
+        mweb_inputs_available.clear();
+        mweb_outputs_available.clear();
+        mweb_kernels_available.clear();
+        mweb_view.reset();
+
+        if (mweb_status != READ_STATUS_OK)
+            return mweb_status;
+    } else if (mweb_missing_count != 0) {
+        return READ_STATUS_INVALID;
+    }
+
     BlockValidationState state;
     if (!CheckBlock(block, state, Params().GetConsensus())) {
         // TODO: We really want to just check merkle tree manually here,
@@ -218,6 +430,9 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
     }
 
     LogPrint(BCLog::CMPCTBLOCK, "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool (incl at least %lu from extra pool) and %lu txn requested\n", hash.ToString(), prefilled_count, mempool_count, extra_count, vtx_missing.size());
+    if (mweb_mempool_count != 0 || mweb_missing_count != 0) {
+        LogPrint(BCLog::CMPCTBLOCK, "Reconstructed MWEB block for %s with %lu components from mempool and %lu components requested\n", hash.ToString(), mweb_mempool_count, mweb_missing_count);
+    }
     if (vtx_missing.size() < 5) {
         for (const auto& tx : vtx_missing) {
             LogPrint(BCLog::CMPCTBLOCK, "Reconstructed block %s required tx %s\n", hash.ToString(), tx->GetHash().ToString());
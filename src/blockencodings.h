@@ -6,10 +6,17 @@
 #define BITCOIN_BLOCKENCODINGS_H
 
 #include <primitives/block.h>
+#include <mw/node/CoinsView.h>
 
 
 class CTxMemPool;
 
+/**
+ * A flag that is ORed into the protocol version to designate that the MWEB extension block
+ * in cmpctblock, getblocktxn and blocktxn messages should be (un)serialized using short IDs.
+ */
+static const int SERIALIZE_MWEB_COMPACT = 0x10000000;
+
 // Transaction compression schemes for compact block relay can be introduced by writing
 // an actual formatter here.
 using TransactionCompression = DefaultFormatter;
@@ -42,9 +49,25 @@ public:
     uint256 blockhash;
     std::vector<uint16_t> indexes;
 
+    // MWEB: Indexes of the extension block inputs, outputs and kernels missing from a compact MWEB block.
+    // Only (un)serialized with SERIALIZE_MWEB_COMPACT.
+    std::vector<uint32_t> mweb_input_indexes;
+    std::vector<uint32_t> mweb_output_indexes;
+    std::vector<uint32_t> mweb_kernel_indexes;
+
+    bool IsEmpty() const noexcept
+    {
+        return indexes.empty() && mweb_input_indexes.empty() && mweb_output_indexes.empty() && mweb_kernel_indexes.empty();
+    }
+
     SERIALIZE_METHODS(BlockTransactionsRequest, obj)
     {
         READWRITE(obj.blockhash, Using<VectorFormatter<DifferenceFormatter>>(obj.indexes));
+        if (s.GetVersion() & SERIALIZE_MWEB_COMPACT) {
+            READWRITE(Using<VectorFormatter<DifferenceFormatter>>(obj.mweb_input_indexes));
+            READWRITE(Using<VectorFormatter<DifferenceFormatter>>(obj.mweb_output_indexes));
+            READWRITE(Using<VectorFormatter<DifferenceFormatter>>(obj.mweb_kernel_indexes));
+        }
     }
 };
 
@@ -54,13 +77,48 @@ public:
     uint256 blockhash;
     std::vector<CTransactionRef> txn;
 
+    // MWEB: The requested extension block components. Only (un)serialized with SERIALIZE_MWEB_COMPACT.
+    std::vector<Input> mweb_inputs;
+    std::vector<Output> mweb_outputs;
+    std::vector<Kernel> mweb_kernels;
+
     BlockTransactions() {}
     explicit BlockTransactions(const BlockTransactionsRequest& req) :
-        blockhash(req.blockhash), txn(req.indexes.size()) {}
+        blockhash(req.blockhash), txn(req.indexes.size()),
+        mweb_inputs(req.mweb_input_indexes.size()),
+        mweb_outputs(req.mweb_output_indexes.size()),
+        mweb_kernels(req.mweb_kernel_indexes.size()) {}
 
     SERIALIZE_METHODS(BlockTransactions, obj)
     {
         READWRITE(obj.blockhash, Using<VectorFormatter<TransactionCompression>>(obj.txn));
+        if (s.GetVersion() & SERIALIZE_MWEB_COMPACT) {
+            READWRITE(obj.mweb_inputs, obj.mweb_outputs, obj.mweb_kernels);
+        }
+    }
+};
+
+/**
+ * MWEB: Short-ID encoding of an extension block.
+ * Sent in place of the full MWEB::Block when compact blocks are (un)serialized with SERIALIZE_MWEB_COMPACT.
+ * The receiver rebuilds the block body from the MWEB transactions in its mempool, and requests the rest.
+ */
+struct CompactMWEBBlock {
+    mw::Header::CPtr header;
+    std::vector<uint64_t> input_shortids;
+    std::vector<uint64_t> output_shortids;
+    std::vector<uint64_t> kernel_shortids;
+
+    bool IsNull() const noexcept { return header == nullptr; }
+
+    SERIALIZE_METHODS(CompactMWEBBlock, obj)
+    {
+        READWRITE(WrapOptionalPtr(obj.header));
+        if (obj.header != nullptr) {
+            READWRITE(Using<VectorFormatter<CustomUintFormatter<6>>>(obj.input_shortids));
+            READWRITE(Using<VectorFormatter<CustomUintFormatter<6>>>(obj.output_shortids));
+            READWRITE(Using<VectorFormatter<CustomUintFormatter<6>>>(obj.kernel_shortids));
+        }
     }
 };
 
@@ -96,6 +154,9 @@ protected:
     std::vector<uint64_t> shorttxids;
     std::vector<PrefilledTransaction> prefilledtxn;
 
+    // MWEB: Short IDs of mweb_block's components, sent instead of mweb_block when serializing with SERIALIZE_MWEB_COMPACT.
+    CompactMWEBBlock mweb_compact;
+
 public:
     static constexpr int SHORTTXIDS_LENGTH = 6;
 
@@ -108,6 +169,7 @@ public:
     CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID);
 
     uint64_t GetShortID(const uint256& txhash) const;
+    uint64_t GetShortID(const mw::Hash& hash) const;
 
     size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
 
@@ -117,7 +179,11 @@ public:
 		
         READWRITE(obj.header, obj.nonce, Using<VectorFormatter<CustomUintFormatter<SHORTTXIDS_LENGTH>>>(obj.shorttxids), obj.prefilledtxn);
         if (fAllowMWEB) {
-            READWRITE(obj.mweb_block);
+            if (s.GetVersion() & SERIALIZE_MWEB_COMPACT) {
+                READWRITE(obj.mweb_compact);
+            } else {
+                READWRITE(obj.mweb_block);
+            }
         }
 
         if (ser_action.ForRead()) {
@@ -134,6 +200,17 @@ protected:
     std::vector<CTransactionRef> txn_available;
     size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
     const CTxMemPool* pool;
+
+    // MWEB: Extension block being rebuilt from a compact MWEB block.
+    mw::Header::CPtr mweb_header;
+    std::vector<boost::optional<Input>> mweb_inputs_available;
+    std::vector<boost::optional<Output>> mweb_outputs_available;
+    std::vector<boost::optional<Kernel>> mweb_kernels_available;
+    size_t mweb_mempool_count = 0;
+    mw::ICoinsView::Ptr mweb_view;
+
+    ReadStatus InitMWEBData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
+    ReadStatus FillMWEBBlock(CBlock& block, const std::vector<Input>& inputs_missing, const std::vector<Output>& outputs_missing, const std::vector<Kernel>& kernels_missing);
 public:
     CBlockHeader header;
     MWEB::Block mweb_block;
@@ -142,7 +219,15 @@ public:
     // extra_txn is a list of extra transactions to look at, in <witness hash, reference> form
     ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
     bool IsTxAvailable(size_t index) const;
-    ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing);
+    // MWEB: Adds the indexes of any extension block components that could not be found locally.
+    void GetMissingMWEBIndexes(BlockTransactionsRequest& req) const;
+    // MWEB: Sets the coins view of the block's parent, against which FillBlock checks the output
+    // root, output count and spent outputs of the rebuilt extension block. Null skips those checks.
+    void SetMWEBView(const mw::ICoinsView::Ptr& view) { mweb_view = view; }
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing,
+                         const std::vector<Input>& mweb_inputs_missing = {},
+                         const std::vector<Output>& mweb_outputs_missing = {},
+                         const std::vector<Kernel>& mweb_kernels_missing = {});
 };
 
 #endif // BITCOIN_BLOCKENCODINGS_H
@@ -0,0 +1,217 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockimport.h>
+
+#include <chainparams.h>
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <shutdown.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <util/threadnames.h>
+#include <validation.h>
+
+#include <cstring>
+
+BlockFileImporter::BlockFileImporter(CBufferedFile& blkdat, uint64_t nStartPos, const CChainParams& chainparams, int threads)
+    : m_blkdat(blkdat), m_chainparams(chainparams), m_num_threads(std::max(1, threads))
+{
+    Start(nStartPos);
+}
+
+void BlockFileImporter::Start(uint64_t nStartPos)
+{
+    LOCK(m_mutex);
+    m_running = true;
+    m_read_done = false;
+    m_last_pos = nStartPos;
+    m_threads.emplace_back([this, nStartPos] {
+        util::ThreadRename("loadblk.read");
+        ThreadRead(nStartPos);
+    });
+    for (int i = 0; i < m_num_threads; ++i) {
+        m_threads.emplace_back([this, i] {
+            util::ThreadRename(strprintf("loadblk.%i", i));
+            ThreadWork();
+        });
+    }
+}
+
+void BlockFileImporter::Stop()
+{
+    std::vector<std::thread> threads;
+    {
+        LOCK(m_mutex);
+        m_running = false;
+        m_cond.notify_all();
+        threads.swap(m_threads);
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    LOCK(m_mutex);
+    m_items.clear();
+    m_queue.clear();
+}
+
+bool BlockFileImporter::Next(Record& record)
+{
+    std::shared_ptr<Item> item;
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (m_items.empty() ? !m_read_done : !m_items.front()->ready) {
+            m_cond.wait(lock);
+        }
+        if (m_items.empty()) return false;
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_last_pos = item->nRecordPos;
+        m_cond.notify_all();
+    }
+    record = std::move(item->record);
+
+    // Records that don't deserialize, or are shorter than their header claims,
+    // may have been partially overwritten by another record. Scan them again
+    // for the start of that record.
+    uint64_t nResumePos = 0;
+    if (!record.block) {
+        nResumePos = item->nRecordPos + 1;
+    } else if (!item->compressed && item->nConsumed < item->nSize) {
+        nResumePos = item->nBlockPos + item->nConsumed;
+    }
+    if (nResumePos != 0) {
+        Stop();
+        Start(nResumePos);
+    }
+    return true;
+}
+
+std::string BlockFileImporter::GetReadError()
+{
+    LOCK(m_mutex);
+    return m_read_error;
+}
+
+void BlockFileImporter::ThreadRead(uint64_t nStartPos)
+{
+    const CMessageHeader::MessageStartChars& message_start = m_chainparams.MessageStart();
+    try {
+        uint64_t nRewind = nStartPos;
+        m_blkdat.SetPos(nRewind);
+        while (!m_blkdat.eof()) {
+            if (ShutdownRequested()) break;
+            {
+                // Don't read further ahead than the file can be rewound to.
+                WAIT_LOCK(m_mutex, lock);
+                while (m_running && nRewind >= m_last_pos + MAX_BLOCK_IMPORT_QUEUE) {
+                    m_cond.wait(lock);
+                }
+                if (!m_running) return;
+            }
+
+            m_blkdat.SetPos(nRewind);
+            nRewind++; // start one byte further next time, in case of failure
+            m_blkdat.SetLimit(); // remove former limit
+            auto item = std::make_shared<Item>();
+            try {
+                // locate a header
+                unsigned char buf[CMessageHeader::MESSAGE_START_SIZE];
+                m_blkdat.FindByte(message_start[0]);
+                item->nRecordPos = m_blkdat.GetPos();
+                nRewind = item->nRecordPos + 1;
+                m_blkdat >> buf;
+                item->compressed = IsCompressedRecord(buf, message_start);
+                if (!item->compressed && memcmp(buf, message_start, CMessageHeader::MESSAGE_START_SIZE))
+                    continue;
+                // read size
+                m_blkdat >> item->nSize;
+                if (item->nSize < (item->compressed ? 4 : 80) || item->nSize > MAX_BLOCK_SERIALIZED_SIZE_WITH_MWEB)
+                    continue;
+            } catch (const std::exception&) {
+                // no valid block header found; don't complain
+                break;
+            }
+
+            item->nBlockPos = m_blkdat.GetPos();
+            m_blkdat.SetLimit(item->nBlockPos + item->nSize);
+            item->data.resize(item->nSize);
+            try {
+                m_blkdat.read((char*)item->data.data(), item->nSize);
+            } catch (const std::exception&) {
+                // The record runs past the end of the file. Keep what was read,
+                // as a block shorter than the record may still fit in it.
+                item->data.resize(m_blkdat.GetPos() - item->nBlockPos);
+            }
+            nRewind = m_blkdat.GetPos();
+
+            LOCK(m_mutex);
+            m_items.push_back(item);
+            m_queue.push_back(std::move(item));
+            m_cond.notify_all();
+        }
+    } catch (const std::runtime_error& e) {
+        LOCK(m_mutex);
+        m_read_error = e.what();
+    }
+
+    LOCK(m_mutex);
+    m_read_done = true;
+    m_cond.notify_all();
+}
+
+void BlockFileImporter::ThreadWork()
+{
+    while (true) {
+        std::shared_ptr<Item> item;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            while (m_running && m_queue.empty()) {
+                m_cond.wait(lock);
+            }
+            if (!m_running) return;
+
+            item = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        Process(*item);
+
+        LOCK(m_mutex);
+        item->ready = true;
+        m_cond.notify_all();
+    }
+}
+
+void BlockFileImporter::Process(Item& item) const
+{
+    item.record.nBlockPos = item.nBlockPos;
+    try {
+        std::vector<uint8_t> decompressed;
+        if (item.compressed && !DecompressRecord(item.data, decompressed)) {
+            throw std::ios_base::failure("Compressed record is corrupt");
+        }
+        const std::vector<uint8_t>& data = item.compressed ? decompressed : item.data;
+
+        auto block = std::make_shared<CBlock>();
+        VectorReader reader(SER_DISK, CLIENT_VERSION, data, 0);
+        reader >> *block;
+        item.nConsumed = data.size() - reader.size();
+
+        // Marks the block as checked if it passes, so AcceptBlock can skip the checks.
+        BlockValidationState state;
+        CheckBlock(*block, state, m_chainparams.GetConsensus());
+
+        item.record.hash = block->GetHash();
+        item.record.block = std::move(block);
+    } catch (const std::exception& e) {
+        item.record.error = e.what();
+    }
+    // The raw record is no longer needed.
+    item.data.clear();
+    item.data.shrink_to_fit();
+}
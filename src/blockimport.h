@@ -0,0 +1,103 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKIMPORT_H
+#define BITCOIN_BLOCKIMPORT_H
+
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CBufferedFile;
+class CChainParams;
+
+//! Maximum number of threads deserializing and checking blocks while importing a block file
+static const int MAX_BLOCK_IMPORT_THREADS = 8;
+//! Maximum number of bytes of a block file read ahead of the block being imported
+static const unsigned int MAX_BLOCK_IMPORT_QUEUE = 32 << 20;
+
+/**
+ * Scans a block file (a blk?????.dat file, or a -loadblock file) for block
+ * records on a reader thread, and deserializes and checks the blocks on worker
+ * threads, handing them out in the order of the file.
+ *
+ * The checks are the context-free ones of CheckBlock, which include the
+ * proof of work. Blocks that pass them are marked as checked, so that
+ * AcceptBlock doesn't repeat them on the thread that imports the blocks.
+ *
+ * If a record doesn't deserialize, or is shorter than its header claims,
+ * the scan resumes from within the record, as it might have been partially
+ * overwritten by the records that follow it.
+ */
+class BlockFileImporter
+{
+public:
+    struct Record {
+        //! Position of the block's data in the file
+        uint64_t nBlockPos{0};
+        //! The block, or nullptr if it failed to deserialize
+        std::shared_ptr<CBlock> block;
+        uint256 hash;
+        //! Why the block failed to deserialize
+        std::string error;
+    };
+
+    /** Starts importing from nStartPos in blkdat, which is owned by the reader thread until the importer is destroyed. */
+    BlockFileImporter(CBufferedFile& blkdat, uint64_t nStartPos, const CChainParams& chainparams, int threads);
+    ~BlockFileImporter() { Stop(); }
+
+    /**
+     * Returns false once the end of the file has been reached, or the reader
+     * failed, in which case GetReadError returns why.
+     */
+    bool Next(Record& record);
+
+    std::string GetReadError();
+
+private:
+    //! A block record found by the reader, which a worker turns into a block.
+    struct Item {
+        uint64_t nRecordPos{0};
+        uint64_t nBlockPos{0};
+        unsigned int nSize{0};
+        bool compressed{false};
+        std::vector<uint8_t> data;
+        //! Number of bytes of the record the block was deserialized from
+        uint64_t nConsumed{0};
+        Record record;
+        bool ready{false};
+    };
+
+    void Start(uint64_t nStartPos);
+    void Stop();
+    void ThreadRead(uint64_t nStartPos);
+    void ThreadWork();
+    void Process(Item& item) const;
+
+    CBufferedFile& m_blkdat;
+    const CChainParams& m_chainparams;
+    const int m_num_threads;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_running GUARDED_BY(m_mutex){false};
+    bool m_read_done GUARDED_BY(m_mutex){false};
+    std::string m_read_error GUARDED_BY(m_mutex);
+    //! Records in file order, until they're handed out
+    std::deque<std::shared_ptr<Item>> m_items GUARDED_BY(m_mutex);
+    //! Records waiting for a worker
+    std::deque<std::shared_ptr<Item>> m_queue GUARDED_BY(m_mutex);
+    //! Position of the last record handed out, which the reader doesn't run too far ahead of
+    uint64_t m_last_pos GUARDED_BY(m_mutex){0};
+    std::vector<std::thread> m_threads;
+};
+
+#endif // BITCOIN_BLOCKIMPORT_H
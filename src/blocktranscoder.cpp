@@ -0,0 +1,179 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blocktranscoder.h>
+
+#include <primitives/transaction.h>
+#include <serialize.h>
+
+#include <cstring>
+#include <ios>
+
+namespace {
+
+/** Stream over a serialized block, which lets the transcoder skip over and copy whole ranges. */
+class RawBlockReader
+{
+public:
+    explicit RawBlockReader(Span<const uint8_t> data) : m_data(data) {}
+
+    void read(char* dst, size_t n)
+    {
+        memcpy(dst, Take(n).data(), n);
+    }
+
+    Span<const uint8_t> Take(size_t n)
+    {
+        if (n > m_data.size() - m_pos) {
+            throw std::ios_base::failure("RawBlockReader::Take(): end of data");
+        }
+        Span<const uint8_t> ret = m_data.subspan(m_pos, n);
+        m_pos += n;
+        return ret;
+    }
+
+    size_t GetPos() const { return m_pos; }
+
+    Span<const uint8_t> Range(size_t begin) const { return m_data.subspan(begin, m_pos - begin); }
+    Span<const uint8_t> Rest() const { return m_data.subspan(m_pos); }
+
+private:
+    Span<const uint8_t> m_data;
+    size_t m_pos{0};
+};
+
+void Append(std::vector<uint8_t>& out, Span<const uint8_t> data)
+{
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+void SkipBytes(RawBlockReader& in)
+{
+    in.Take(ReadCompactSize(in));
+}
+
+void SkipInputs(RawBlockReader& in, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; ++i) {
+        in.Take(32 + 4); // prevout
+        SkipBytes(in);   // scriptSig
+        in.Take(4);      // nSequence
+    }
+}
+
+void SkipOutputs(RawBlockReader& in)
+{
+    const uint64_t count = ReadCompactSize(in);
+    for (uint64_t i = 0; i < count; ++i) {
+        in.Take(8);    // nValue
+        SkipBytes(in); // scriptPubKey
+    }
+}
+
+/**
+ * Mirrors UnserializeTransaction and SerializeTransaction, copying the ranges
+ * of the transaction that are kept. Returns false if the transaction carries
+ * MWEB transaction data, which isn't transcoded.
+ */
+bool TranscodeTransaction(RawBlockReader& in, std::vector<uint8_t>& out, bool allow_witness, bool allow_mweb)
+{
+    Append(out, in.Take(4)); // nVersion
+
+    unsigned char flags = 0;
+    size_t vin_begin = in.GetPos();
+    uint64_t vin_count = ReadCompactSize(in);
+    Span<const uint8_t> vin, vout;
+    if (vin_count == 0) {
+        /* We read a dummy or an empty vin. */
+        in.read((char*)&flags, 1);
+        if (flags != 0) {
+            vin_begin = in.GetPos();
+            vin_count = ReadCompactSize(in);
+            SkipInputs(in, vin_count);
+            vin = in.Range(vin_begin);
+            const size_t vout_begin = in.GetPos();
+            SkipOutputs(in);
+            vout = in.Range(vout_begin);
+        } else {
+            vin = in.Range(vin_begin).first(1);
+        }
+    } else {
+        SkipInputs(in, vin_count);
+        vin = in.Range(vin_begin);
+        const size_t vout_begin = in.GetPos();
+        SkipOutputs(in);
+        vout = in.Range(vout_begin);
+    }
+
+    Span<const uint8_t> witness;
+    if (flags & 1) {
+        const size_t witness_begin = in.GetPos();
+        for (uint64_t i = 0; i < vin_count; ++i) {
+            const uint64_t stack_size = ReadCompactSize(in);
+            for (uint64_t j = 0; j < stack_size; ++j) {
+                SkipBytes(in);
+            }
+        }
+        witness = in.Range(witness_begin);
+    }
+    if (flags & 8) {
+        uint8_t has_mweb_tx;
+        in.read((char*)&has_mweb_tx, 1);
+        if (has_mweb_tx != 0) return false;
+    }
+    if (flags & ~(1 | 8)) return false;
+
+    unsigned char out_flags = 0;
+    if (allow_witness) out_flags |= flags & 1;
+    if (allow_mweb) out_flags |= flags & 8;
+
+    if (out_flags) {
+        out.push_back(0); // empty vin dummy
+        out.push_back(out_flags);
+    }
+    Append(out, vin);
+    if (vout.empty()) {
+        out.push_back(0); // the empty vout that was never serialized
+    } else {
+        Append(out, vout);
+    }
+    if (out_flags & 1) {
+        Append(out, witness);
+    }
+    if (out_flags & 8) {
+        out.push_back(0); // null mweb_tx
+    }
+    Append(out, in.Take(4)); // nLockTime
+    return true;
+}
+
+} // namespace
+
+bool TranscodeBlock(Span<const uint8_t> block, int serialize_flags, std::vector<uint8_t>& out)
+{
+    const bool allow_witness = !(serialize_flags & SERIALIZE_TRANSACTION_NO_WITNESS);
+    const bool allow_mweb = !(serialize_flags & SERIALIZE_NO_MWEB);
+
+    out.clear();
+    out.reserve(block.size());
+    try {
+        RawBlockReader in(block);
+        Append(out, in.Take(80)); // header
+
+        const size_t count_begin = in.GetPos();
+        const uint64_t tx_count = ReadCompactSize(in);
+        Append(out, in.Range(count_begin));
+        for (uint64_t i = 0; i < tx_count; ++i) {
+            if (!TranscodeTransaction(in, out, allow_witness, allow_mweb)) return false;
+        }
+
+        // The MWEB block, if any, follows the transactions.
+        if (allow_mweb) {
+            Append(out, in.Rest());
+        }
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+    return true;
+}
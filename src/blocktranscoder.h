@@ -0,0 +1,25 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKTRANSCODER_H
+#define BITCOIN_BLOCKTRANSCODER_H
+
+#include <span.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Re-encodes a fully serialized block (as stored on disk, with witnesses and
+ * MWEB data) with the given SERIALIZE_TRANSACTION_NO_WITNESS and
+ * SERIALIZE_NO_MWEB flags, without deserializing it into a CBlock.
+ *
+ * The result is byte for byte what serializing the CBlock with those flags
+ * would produce. Returns false if the block can't be transcoded, i.e. it's
+ * malformed, or a transaction in vtx carries MWEB transaction data, in which
+ * case the caller should fall back to deserializing the block.
+ */
+bool TranscodeBlock(Span<const uint8_t> block, int serialize_flags, std::vector<uint8_t>& out);
+
+#endif // BITCOIN_BLOCKTRANSCODER_H
@@ -182,7 +182,9 @@ public:
     uint32_t nBits{0};
     uint32_t nNonce{0};
 
-    //! MWEB data (only populated when BLOCK_HAVE_MWEB is set)
+    //! MWEB data (only populated when BLOCK_HAVE_MWEB is set). The header is
+    //! only held in memory for blocks connected since startup; use
+    //! GetMWEBHeader() to read it.
     mw::Header::CPtr mweb_header{nullptr};
     uint256 hogex_hash{};
     CAmount mweb_amount{0};
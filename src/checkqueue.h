@@ -8,6 +8,10 @@
 #include <sync.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
@@ -25,11 +29,31 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Each worker (and the master) has its own queue of verifications, which
+  * the master spreads new batches over. Workers take from the back of their
+  * own queue, and steal from the front of the others' when it runs dry, so
+  * they rarely contend for the same lock. The number of verifications taken
+  * at once adapts to how long they take: cheap ones are taken in bulk, and
+  * expensive ones a few at a time, so that no worker sits on a long batch
+  * while the others are idle.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
+    //! Maximum number of per-worker queues. Workers beyond this share a queue.
+    static constexpr int MAX_WORKER_QUEUES = 64;
+
+    //! Batches are sized to take about this long to verify
+    static constexpr int64_t TARGET_BATCH_NANOS = 100000;
+
+    //! Verifications waiting to be taken by one worker, or stolen by another
+    struct WorkerQueue {
+        boost::mutex mutex;
+        std::deque<T> checks;
+    };
+
     //! Mutex to protect the inner state
     boost::mutex mutex;
 
@@ -39,18 +63,24 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
+    //! The per-worker queues. The first one is the master's.
+    //! Lock order: mutex, then a worker queue's mutex.
+    std::unique_ptr<WorkerQueue[]> vWorkerQueues;
+
+    //! The number of worker queues in use.
+    std::atomic<int> nWorkerQueues;
+
+    //! The number of worker threads that have joined.
+    int nWorkers;
+
+    //! The worker queue the next batch is added to.
+    int nNextQueue;
 
     //! The number of workers (including the master) that are idle.
     int nIdle;
 
-    //! The total number of workers (including the master).
-    int nTotal;
-
     //! The temporary evaluation result.
-    bool fAllOk;
+    std::atomic<bool> fAllOk;
 
     /**
      * Number of verifications that haven't completed yet.
@@ -59,35 +89,71 @@ private:
      */
     unsigned int nTodo;
 
+    //! Number of verifications in the worker queues.
+    std::atomic<unsigned int> nQueued;
+
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    //! Moving average of the time a verification takes, in nanoseconds
+    std::atomic<int64_t> nCheckNanos;
+
+    unsigned int GetBatchSize() const
+    {
+        const int64_t nanos = std::max<int64_t>(1, nCheckNanos.load(std::memory_order_relaxed));
+        return std::max<int64_t>(1, std::min<int64_t>(nBatchSize, TARGET_BATCH_NANOS / nanos));
+    }
+
+    /**
+     * Moves a batch of verifications into vChecks, from the worker's own
+     * queue if it has any, or else from another's. Returns the number moved.
+     */
+    unsigned int Take(int nOwn, std::vector<T>& vChecks)
+    {
+        const unsigned int nMax = GetBatchSize();
+        const int nQueues = nWorkerQueues.load();
+        for (int i = 0; i < nQueues; i++) {
+            WorkerQueue& worker_queue = vWorkerQueues[(nOwn + i) % nQueues];
+            boost::unique_lock<boost::mutex> lock(worker_queue.mutex);
+            std::deque<T>& checks = worker_queue.checks;
+            if (checks.empty()) continue;
+            if (i == 0) {
+                // As the order of booleans doesn't matter, the own queue is used as a LIFO (stack)
+                const unsigned int nNow = std::min<size_t>(nMax, checks.size());
+                vChecks.resize(nNow);
+                for (unsigned int j = 0; j < nNow; j++) {
+                    // We want the lock on the mutex to be as short as possible, so swap jobs from the
+                    // queue to the local batch vector instead of copying.
+                    vChecks[j].swap(checks.back());
+                    checks.pop_back();
+                }
+            } else {
+                // Steal up to half of another worker's queue, from the end it isn't working on
+                const unsigned int nNow = std::min<size_t>(nMax, (checks.size() + 1) / 2);
+                vChecks.resize(nNow);
+                for (unsigned int j = 0; j < nNow; j++) {
+                    vChecks[j].swap(checks.front());
+                    checks.pop_front();
+                }
+            }
+            nQueued -= vChecks.size();
+            return vChecks.size();
+        }
+        return 0;
+    }
+
     /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    bool Loop(int nOwn, bool fMaster = false)
     {
         boost::condition_variable& cond = fMaster ? condMaster : condWorker;
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
+            const unsigned int nNow = Take(nOwn, vChecks);
+            if (nNow == 0) {
                 boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty()) {
+                while (nQueued == 0) {
                     if (fMaster && nTodo == 0) {
-                        nTotal--;
                         bool fRet = fAllOk;
                         // reset the status for new work later
                         fAllOk = true;
@@ -98,27 +164,29 @@ private:
                     cond.wait(lock); // wait
                     nIdle--;
                 }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
             }
+
+            // Check whether we need to do work at all
+            bool fOk = fAllOk;
+            const auto start = std::chrono::steady_clock::now();
             // execute work
             for (T& check : vChecks)
                 if (fOk)
                     fOk = check();
+            if (fOk) {
+                const int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / nNow;
+                const int64_t average = nCheckNanos.load(std::memory_order_relaxed);
+                nCheckNanos.store(average + (nanos - average) / 4, std::memory_order_relaxed);
+            }
             vChecks.clear();
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (!fOk) fAllOk = false;
+            nTodo -= nNow;
+            if (nTodo == 0 && !fMaster)
+                // We processed the last element; inform the master it can exit and return the result
+                condMaster.notify_one();
         } while (true);
     }
 
@@ -127,29 +195,46 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn) {}
+    explicit CCheckQueue(unsigned int nBatchSizeIn)
+        : vWorkerQueues(new WorkerQueue[MAX_WORKER_QUEUES]), nWorkerQueues(1), nWorkers(0), nNextQueue(0), nIdle(0), fAllOk(true), nTodo(0), nQueued(0), nBatchSize(nBatchSizeIn), nCheckNanos(TARGET_BATCH_NANOS) {}
 
     //! Worker thread
     void Thread()
     {
-        Loop();
+        int nOwn;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            nOwn = 1 + nWorkers % (MAX_WORKER_QUEUES - 1);
+            nWorkers++;
+            nWorkerQueues = std::min(nWorkers + 1, MAX_WORKER_QUEUES);
+        }
+        Loop(nOwn);
     }
 
     //! Wait until execution finishes, and return whether all evaluations were successful.
     bool Wait()
     {
-        return Loop(true);
+        return Loop(0, true);
     }
 
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
+        if (vChecks.empty()) return;
+
         boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
-        }
         nTodo += vChecks.size();
+        nQueued += vChecks.size();
+        {
+            // Spread batches over the worker queues; workers steal from each other to even them out.
+            nNextQueue = (nNextQueue + 1) % nWorkerQueues;
+            WorkerQueue& worker_queue = vWorkerQueues[nNextQueue];
+            boost::unique_lock<boost::mutex> queue_lock(worker_queue.mutex);
+            for (T& check : vChecks) {
+                worker_queue.checks.emplace_back();
+                check.swap(worker_queue.checks.back());
+            }
+        }
         if (vChecks.size() == 1)
             condWorker.notify_one();
         else if (vChecks.size() > 1)
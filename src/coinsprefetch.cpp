@@ -0,0 +1,210 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coinsprefetch.h>
+
+#include <chainparams.h>
+#include <logging.h>
+#include <mw/db/CoinDB.h>
+#include <tinyformat.h>
+#include <util/threadnames.h>
+#include <validation.h>
+
+bool CCoinsViewPrefetch::GetCoin(const COutPoint& outpoint, Coin& coin) const
+{
+    {
+        LOCK(m_mutex);
+        auto it = m_coins.find(outpoint);
+        if (it != m_coins.end()) {
+            coin = std::move(it->second);
+            m_coins.erase(it);
+            return true;
+        }
+    }
+
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewPrefetch::BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const mw::CoinsViewCache::Ptr& derivedView, bool erase)
+{
+    {
+        LOCK(m_mutex);
+        ++m_generation;
+        m_coins.clear();
+    }
+
+    bool ret = base->BatchWrite(mapCoins, hashBlock, derivedView, erase);
+
+    // Anything read while the database was being written to may be stale.
+    {
+        LOCK(m_mutex);
+        ++m_generation;
+        m_coins.clear();
+    }
+
+    return ret;
+}
+
+void CCoinsViewPrefetch::Prefetch(const CCoinsView& db, const std::vector<COutPoint>& outpoints)
+{
+    uint64_t generation;
+    {
+        LOCK(m_mutex);
+        if (m_coins.size() >= MAX_PREFETCHED_COINS) return;
+        generation = m_generation;
+    }
+
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    coins.reserve(outpoints.size());
+    for (const COutPoint& outpoint : outpoints) {
+        Coin coin;
+        try {
+            if (!db.GetCoin(outpoint, coin)) continue;
+        } catch (const std::runtime_error& e) {
+            // Read errors are left for the error catcher to handle, once the coin is actually needed.
+            LogPrint(BCLog::COINDB, "%s: failed to read coin: %s\n", __func__, e.what());
+            return;
+        }
+        coins.emplace_back(outpoint, std::move(coin));
+    }
+
+    LOCK(m_mutex);
+    if (generation != m_generation) return;
+    for (auto& entry : coins) {
+        if (m_coins.size() >= MAX_PREFETCHED_COINS) break;
+        m_coins.emplace(entry.first, std::move(entry.second));
+    }
+}
+
+size_t CCoinsViewPrefetch::GetPrefetchedCount() const
+{
+    LOCK(m_mutex);
+    return m_coins.size();
+}
+
+void CBlockPrefetcher::Prefetch(const std::vector<BlockRef>& blocks, const mw::DBWrapper::Ptr& mweb_db)
+{
+    LOCK(m_mutex);
+
+    std::set<uint256> wanted;
+    for (const BlockRef& block : blocks) {
+        wanted.insert(block.hash);
+    }
+
+    for (auto it = m_blocks.begin(); it != m_blocks.end();) {
+        it = wanted.count(it->first) ? std::next(it) : m_blocks.erase(it);
+    }
+
+    m_queue.clear();
+    std::set<uint256> in_progress_or_read;
+    for (const uint256& hash : m_wanted) {
+        if (wanted.count(hash)) in_progress_or_read.insert(hash);
+    }
+    m_wanted = std::move(in_progress_or_read);
+
+    for (const BlockRef& block : blocks) {
+        if (m_wanted.insert(block.hash).second) {
+            m_queue.push_back(block);
+        }
+    }
+
+    m_mweb_db = mweb_db;
+
+    if (!m_running && !m_queue.empty()) {
+        m_running = true;
+        for (int i = 0; i < BLOCK_PREFETCH_THREADS; ++i) {
+            m_threads.emplace_back([this, i] {
+                util::ThreadRename(strprintf("prefetch.%i", i));
+                ThreadPrefetch();
+            });
+        }
+    }
+
+    m_cond.notify_all();
+}
+
+std::shared_ptr<const CBlock> CBlockPrefetcher::TakeBlock(const uint256& hash)
+{
+    LOCK(m_mutex);
+    auto it = m_blocks.find(hash);
+    if (it == m_blocks.end()) return nullptr;
+
+    std::shared_ptr<const CBlock> block = std::move(it->second);
+    m_blocks.erase(it);
+    m_wanted.erase(hash);
+    return block;
+}
+
+void CBlockPrefetcher::Stop()
+{
+    std::vector<std::thread> threads;
+    {
+        LOCK(m_mutex);
+        m_running = false;
+        m_queue.clear();
+        m_cond.notify_all();
+        threads.swap(m_threads);
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    LOCK(m_mutex);
+    m_wanted.clear();
+    m_blocks.clear();
+}
+
+void CBlockPrefetcher::ThreadPrefetch()
+{
+    while (true) {
+        BlockRef ref;
+        mw::DBWrapper::Ptr mweb_db;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            while (m_running && m_queue.empty()) {
+                m_cond.wait(lock);
+            }
+            if (!m_running) return;
+
+            ref = m_queue.front();
+            m_queue.pop_front();
+            mweb_db = m_mweb_db;
+        }
+
+        auto block = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*block, ref.pos, Params().GetConsensus()) || block->GetHash() != ref.hash) {
+            LOCK(m_mutex);
+            m_wanted.erase(ref.hash);
+            continue;
+        }
+
+        std::vector<COutPoint> outpoints;
+        for (const CTransactionRef& tx : block->vtx) {
+            if (tx->IsCoinBase()) continue;
+            for (const CTxIn& txin : tx->vin) {
+                outpoints.push_back(txin.prevout);
+            }
+        }
+        m_view.Prefetch(m_db, outpoints);
+
+        if (!block->mweb_block.IsNull() && mweb_db != nullptr) {
+            std::vector<mw::Hash> output_ids;
+            for (const Input& input : block->mweb_block.m_block->GetInputs()) {
+                output_ids.push_back(input.GetOutputID());
+            }
+            try {
+                CoinDB(mweb_db.get()).GetUTXOs(output_ids);
+            } catch (const std::exception& e) {
+                LogPrint(BCLog::COINDB, "%s: failed to read MWEB UTXOs: %s\n", __func__, e.what());
+            }
+        }
+
+        LOCK(m_mutex);
+        // Only keep the block if it's still wanted.
+        if (m_wanted.count(ref.hash)) {
+            m_blocks.emplace(ref.hash, std::move(block));
+        }
+    }
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSPREFETCH_H
+#define BITCOIN_COINSPREFETCH_H
+
+#include <coins.h>
+#include <flatfile.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//! -blockprefetch default: the number of blocks ahead of the one being connected to read and prefetch coins for
+static const int DEFAULT_BLOCK_PREFETCH = 8;
+//! Maximum value of -blockprefetch
+static const int MAX_BLOCK_PREFETCH = 64;
+//! Number of threads reading blocks and coins ahead of block connection
+static const int BLOCK_PREFETCH_THREADS = 2;
+//! Maximum number of prefetched coins held at once
+static const size_t MAX_PREFETCHED_COINS = 200000;
+
+/**
+ * CCoinsView layer, sitting between the coins tip cache and the database, that
+ * serves coins which CBlockPrefetcher read from the database ahead of time.
+ *
+ * A prefetched coin is handed out once, at which point it lives on in the cache
+ * above. Since the cache above is always consulted first, a prefetched coin can
+ * only be stale if the database changed after it was read, so everything
+ * prefetched is dropped whenever the cache is flushed through this view.
+ */
+class CCoinsViewPrefetch final : public CCoinsViewBacked
+{
+public:
+    explicit CCoinsViewPrefetch(CCoinsView* view) : CCoinsViewBacked(view) {}
+
+    bool GetCoin(const COutPoint& outpoint, Coin& coin) const override;
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const mw::CoinsViewCache::Ptr& derivedView, bool erase) override;
+
+    /**
+     * Reads the coins from db (which must be the database underlying this view),
+     * and holds on to them until they're requested or the view is flushed.
+     * Coins that are missing or already prefetched are skipped. Thread safe.
+     */
+    void Prefetch(const CCoinsView& db, const std::vector<COutPoint>& outpoints);
+
+    size_t GetPrefetchedCount() const;
+
+private:
+    mutable Mutex m_mutex;
+    mutable std::unordered_map<COutPoint, Coin, SaltedOutpointHasher> m_coins GUARDED_BY(m_mutex);
+    //! Bumped whenever the database is written to, so that reads racing with a flush are discarded.
+    uint64_t m_generation GUARDED_BY(m_mutex){0};
+};
+
+/**
+ * Reads upcoming blocks from disk on worker threads, and prefetches the coins
+ * their inputs spend, so that block connection doesn't stall on disk reads.
+ *
+ * Transparent coins are prefetched into a CCoinsViewPrefetch. MWEB UTXOs are
+ * read through the MWEB database, which warms the database and OS caches for
+ * when the MWEB view looks them up.
+ */
+class CBlockPrefetcher
+{
+public:
+    struct BlockRef {
+        uint256 hash;
+        FlatFilePos pos;
+    };
+
+    CBlockPrefetcher(CCoinsViewPrefetch& view, const CCoinsView& db) : m_view(view), m_db(db) {}
+    ~CBlockPrefetcher() { Stop(); }
+
+    /**
+     * Sets the blocks to prefetch, in the order they will be connected.
+     * Queued or read blocks that are no longer wanted are dropped.
+     * Worker threads are started on first use.
+     */
+    void Prefetch(const std::vector<BlockRef>& blocks, const mw::DBWrapper::Ptr& mweb_db);
+
+    /** Returns the block if a worker has already read it, or nullptr otherwise. */
+    std::shared_ptr<const CBlock> TakeBlock(const uint256& hash);
+
+    /** Stops and joins the worker threads. Blocks that were read are discarded. */
+    void Stop();
+
+private:
+    void ThreadPrefetch();
+
+    CCoinsViewPrefetch& m_view;
+    const CCoinsView& m_db;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_running GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads GUARDED_BY(m_mutex);
+    std::deque<BlockRef> m_queue GUARDED_BY(m_mutex);
+    //! Blocks that are queued, being read, or read. Used to avoid reading a block twice.
+    std::set<uint256> m_wanted GUARDED_BY(m_mutex);
+    std::map<uint256, std::shared_ptr<const CBlock>> m_blocks GUARDED_BY(m_mutex);
+    mw::DBWrapper::Ptr m_mweb_db GUARDED_BY(m_mutex);
+};
+
+#endif // BITCOIN_COINSPREFETCH_H
@@ -90,6 +90,9 @@ typedef char* sockopt_arg_type;
 // __APPLE__ poll is broke https://github.com/bitcoin/bitcoin/pull/14336#issuecomment-437384408
 #if defined(__linux__)
 #define USE_POLL
+// The socket handler waits on an edge-triggered epoll instance, which sockets
+// stay registered with for as long as they're open.
+#define USE_EPOLL
 #endif
 
 bool static inline IsSelectableSocket(const SOCKET& s) {
@@ -477,6 +477,21 @@ public:
             }
         return false;
     }
+
+    /** for_each calls fn with every element in the table that hasn't been
+     * marked for garbage collection, e.g. to persist the cache.
+     *
+     * for_each must not be called concurrently with insert.
+     *
+     * @param fn the function to call with each element
+     */
+    template <typename Fn>
+    void for_each(Fn fn) const
+    {
+        for (uint32_t i = 0; i < size; ++i)
+            if (!collection_flags.bit_is_set(i))
+                fn(table[i]);
+    }
 };
 } // namespace CuckooCache
 
@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/strencodings.h>
@@ -71,6 +72,9 @@ static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
 /* RPC Auth Whitelist */
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
+/* Limits on the calls of batch requests */
+static size_t g_rpc_batch_threads = DEFAULT_RPC_BATCH_THREADS;
+static std::chrono::seconds g_rpc_batch_timeout{DEFAULT_RPC_BATCH_TIMEOUT};
 
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
@@ -180,6 +184,9 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
         return false;
     }
 
+    // Whether the reply was sent or started while the result was produced,
+    // see JSONRPCRequest::StreamResult
+    bool streamed = false;
     try {
         // Parse request
         UniValue valRequest;
@@ -204,7 +211,26 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            jreq.resultStream = [&](const std::function<void(JSONWriter&)>& write_result) {
+                HTTPReplyStream stream(req, HTTP_OK, "application/json");
+                JSONStreamWriter writer([&stream](std::string&& chunk) { stream.Write(std::move(chunk)); });
+                try {
+                    writer.BeginObject();
+                    writer.Key("result");
+                    write_result(writer);
+                    writer.KV("error", NullUniValue);
+                    writer.KV("id", jreq.id);
+                    writer.EndObject();
+                    writer.Flush();
+                } catch (...) {
+                    streamed = stream.Started();
+                    throw;
+                }
+                stream.End("\n");
+                streamed = true;
+            };
             UniValue result = tableRPC.execute(jreq);
+            if (streamed) return true;
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -227,7 +253,8 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            auto runner = [](size_t count, const std::function<void(size_t)>& fn) { HTTPRunParallel(count, g_rpc_batch_threads, fn); };
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), runner, g_rpc_batch_timeout);
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
@@ -235,9 +262,12 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        // A streamed reply can't turn into an error anymore; it ends cut short
+        if (streamed) return false;
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (streamed) return false;
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
@@ -289,6 +319,8 @@ bool StartHTTPRPC(const util::Ref& context)
     LogPrint(BCLog::RPC, "Starting HTTP RPC server\n");
     if (!InitRPCAuthentication())
         return false;
+    g_rpc_batch_threads = std::max<int64_t>(gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 1);
+    g_rpc_batch_timeout = std::chrono::seconds{std::max<int64_t>(gArgs.GetArg("-rpcbatchtimeout", DEFAULT_RPC_BATCH_TIMEOUT), 0)};
 
     auto handle_rpc = [&context](HTTPRequest* req, const std::string&) { return HTTPReq_JSONRPC(context, req); };
     RegisterHTTPHandler("/", true, handle_rpc);
@@ -5,10 +5,17 @@
 #ifndef BITCOIN_HTTPRPC_H
 #define BITCOIN_HTTPRPC_H
 
+#include <stdint.h>
+
 namespace util {
 class Ref;
 } // namespace util
 
+/** Maximum number of RPC worker threads the calls of one batch request run on at once */
+static const int DEFAULT_RPC_BATCH_THREADS = 1;
+/** Time limit in seconds for the calls of one batch request to start, or 0 for none */
+static const int64_t DEFAULT_RPC_BATCH_TIMEOUT = 0;
+
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -11,11 +11,14 @@
 #include <rpc/protocol.h> // For HTTP status codes
 #include <shutdown.h>
 #include <sync.h>
+#include <util/memory.h>
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <util/threadnames.h>
 #include <util/translation.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <memory>
 #include <stdio.h>
@@ -74,6 +77,8 @@ private:
     Mutex cs;
     std::condition_variable cond;
     std::deque<std::unique_ptr<WorkItem>> queue;
+    /** Items that help finish work already running, which don't count towards maxDepth */
+    std::deque<std::unique_ptr<WorkItem>> helpers;
     bool running;
     size_t maxDepth;
 
@@ -98,6 +103,13 @@ public:
         cond.notify_one();
         return true;
     }
+    /** Enqueue a work item that helps finish one that is already running */
+    void EnqueueHelper(std::unique_ptr<WorkItem> item)
+    {
+        LOCK(cs);
+        helpers.push_back(std::move(item));
+        cond.notify_one();
+    }
     /** Thread function */
     void Run()
     {
@@ -105,12 +117,13 @@ public:
             std::unique_ptr<WorkItem> i;
             {
                 WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
+                while (running && queue.empty() && helpers.empty())
                     cond.wait(lock);
                 if (!running)
                     break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                std::deque<std::unique_ptr<WorkItem>>& next = helpers.empty() ? queue : helpers;
+                i = std::move(next.front());
+                next.pop_front();
             }
             (*i)();
         }
@@ -124,6 +137,20 @@ public:
     }
 };
 
+/** Work item that runs a function */
+class HTTPFunctionClosure final : public HTTPClosure
+{
+public:
+    explicit HTTPFunctionClosure(std::function<void()> func) : m_func(std::move(func)) {}
+    void operator()() override
+    {
+        m_func();
+    }
+
+private:
+    std::function<void()> m_func;
+};
+
 struct HTTPPathHandler
 {
     HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
@@ -436,6 +463,50 @@ void StartHTTPServer()
     }
 }
 
+void HTTPRunParallel(size_t count, size_t max_threads, const std::function<void(size_t)>& func)
+{
+    // Calls are handed out by index to this thread and to the helpers it enqueues, until none
+    // are left. Helpers that only get to run after that have nothing to do, and this thread
+    // makes progress even if none of them do, e.g. because every worker is busy with a batch.
+    struct Job {
+        Job(size_t count_in, const std::function<void(size_t)>& func_in) : count(count_in), func(func_in) {}
+        const size_t count;
+        const std::function<void(size_t)>& func; //!< Only valid while some calls haven't returned
+        std::atomic<size_t> next{0};
+        Mutex mutex;
+        std::condition_variable cond;
+        size_t done GUARDED_BY(mutex){0};
+
+        void Run()
+        {
+            size_t ran = 0;
+            for (size_t i = next++; i < count; i = next++) {
+                func(i);
+                ++ran;
+            }
+            if (ran == 0) return;
+            LOCK(mutex);
+            done += ran;
+            if (done == count) cond.notify_all();
+        }
+    };
+
+    if (count == 0) return;
+    auto job = std::make_shared<Job>(count, func);
+    if (workQueue) {
+        const size_t helpers = std::min(count, std::max<size_t>(max_threads, 1)) - 1;
+        for (size_t i = 0; i < helpers; ++i) {
+            workQueue->EnqueueHelper(MakeUnique<HTTPFunctionClosure>([job] { job->Run(); }));
+        }
+    }
+    job->Run();
+
+    WAIT_LOCK(job->mutex, lock);
+    while (job->done < job->count) {
+        job->cond.wait(lock);
+    }
+}
+
 void InterruptHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Interrupting HTTP server\n");
@@ -517,7 +588,11 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (replyStreaming) {
+        // The body was cut short, e.g. by an exception while producing it
+        LogPrintf("%s: Unfinished reply\n", __func__);
+        AbortReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -563,6 +638,22 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/** Re-enable reading from the socket once a reply was sent. This is the
+ * second part of the libevent workaround above. The connection is looked up
+ * before sending, as sending frees a request that lost its connection.
+ */
+static void ReenableConnectionRead(evhttp_connection* conn)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -580,21 +671,166 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     evbuffer_add(evb, strReply.data(), strReply.size());
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
+        ReenableConnectionRead(conn);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** Amount of a streamed reply that may wait to be sent before the worker producing it is held up */
+static const size_t MAX_REPLY_PENDING = 4 * 1024 * 1024;
+
+/** How much of a streamed reply waits to be sent. Pieces are counted from the
+ * time a worker writes them until the connection's output buffer was flushed,
+ * so a slow client holds up the worker instead of the reply piling up in
+ * memory.
+ */
+struct HTTPReplyFlow
+{
+    Mutex cs;
+    std::condition_variable cond;
+    //! Bytes written by the worker and not yet added to the output buffer
+    size_t queued GUARDED_BY(cs){0};
+    //! Bytes in the output buffer when it was last added to
+    size_t buffered GUARDED_BY(cs){0};
+    //! Whether the connection was closed
+    bool closed GUARDED_BY(cs){false};
+};
+
+/** Called on the main http thread once the output buffer of a streamed reply was flushed */
+static void http_reply_flushed_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPReplyFlow* flow = static_cast<HTTPReplyFlow*>(arg);
+    LOCK(flow->cs);
+    flow->buffered = 0;
+    flow->cond.notify_all();
+}
+
+/** Called on the main http thread when the connection of a streamed reply is closed before it ended */
+static void http_reply_closed_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPReplyFlow* flow = static_cast<HTTPReplyFlow*>(arg);
+    LOCK(flow->cs);
+    flow->closed = true;
+    flow->cond.notify_all();
+}
+
+/** The pieces of a streamed reply are sent from the main http thread like
+ * WriteReply, in the order they were triggered. If the client goes away in the
+ * meantime, libevent detaches the unfinished request from its connection and
+ * ignores further pieces, until evhttp_send_reply_end frees it.
+ */
+void HTTPRequest::StartReply(int nStatus)
+{
+    assert(!replySent && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    // HTTP/1.0 clients can't receive chunks, and find the end of the body when
+    // the connection closes instead. Don't keep it alive for them: libevent
+    // would announce the empty body it holds so far as the whole reply.
+    struct evkeyvalq* input_headers = evhttp_request_get_input_headers(req);
+    const char* connection = evhttp_find_header(input_headers, "Connection");
+    if (connection && evutil_ascii_strcasecmp(connection, "keep-alive") == 0) {
+        evhttp_remove_header(input_headers, "Connection");
+    }
+    auto req_copy = req;
+    auto flow = std::make_shared<HTTPReplyFlow>();
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus, flow]{
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+        // The flow outlives the callbacks: EndReply unsets them while holding it.
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, http_reply_closed_cb, flow.get());
+        } else {
+            http_reply_closed_cb(nullptr, flow.get());
         }
     });
     ev->trigger(nullptr);
     replySent = true;
+    replyStreaming = true;
+    replyFlow = std::move(flow);
+}
+
+bool HTTPRequest::WriteReplyChunk(std::string chunk)
+{
+    assert(replyStreaming && req);
+    {
+        WAIT_LOCK(replyFlow->cs, lock);
+        while (!replyFlow->closed && replyFlow->queued + replyFlow->buffered > MAX_REPLY_PENDING) {
+            if (ShutdownRequested()) return false;
+            replyFlow->cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if (replyFlow->closed || ShutdownRequested()) return false;
+        if (chunk.empty()) return true; // an empty chunk would end the chunked body
+        replyFlow->queued += chunk.size();
+    }
+    auto req_copy = req;
+    auto flow = replyFlow;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, flow, chunk]{
+        size_t buffered = 0;
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            struct evbuffer* evb = evhttp_request_get_output_buffer(req_copy);
+            assert(evb);
+            evbuffer_add(evb, chunk.data(), chunk.size());
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+            evhttp_send_reply_chunk_with_cb(req_copy, evb, http_reply_flushed_cb, flow.get());
+            buffered = evbuffer_get_length(bufferevent_get_output(evhttp_connection_get_bufferevent(conn)));
+#else
+            // Without a flush callback, only the pieces still to be added are held back
+            evhttp_send_reply_chunk(req_copy, evb);
+#endif
+        }
+        LOCK(flow->cs);
+        flow->queued -= chunk.size();
+        flow->buffered = buffered;
+        flow->cond.notify_all();
+    });
+    ev->trigger(nullptr);
+    return true;
+}
+
+void HTTPRequest::EndReply()
+{
+    assert(replyStreaming && req);
+    auto req_copy = req;
+    auto flow = std::move(replyFlow);
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, flow]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, nullptr, nullptr);
+        }
+        evhttp_send_reply_end(req_copy);
+        ReenableConnectionRead(conn);
+    });
+    ev->trigger(nullptr);
+    replyStreaming = false;
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::AbortReply()
+{
+    assert(replyStreaming && req);
+    auto req_copy = req;
+    auto flow = std::move(replyFlow);
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, flow]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            // Freeing the connection closes it and frees the request, without
+            // the last chunk that would tell the client the body is complete.
+            evhttp_connection_set_closecb(conn, nullptr, nullptr);
+            evhttp_connection_free(conn);
+        } else {
+            // The client is gone, and nothing more is sent to it
+            evhttp_send_reply_end(req_copy);
+        }
+    });
+    ev->trigger(nullptr);
+    replyStreaming = false;
     req = nullptr; // transferred back to main thread
 }
 
@@ -638,6 +874,42 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const
     }
 }
 
+HTTPReplyStream::HTTPReplyStream(HTTPRequest* req, int nStatus, const std::string& content_type)
+    : m_req(req), m_status(nStatus), m_content_type(content_type)
+{
+}
+
+void HTTPReplyStream::Start()
+{
+    m_req->WriteHeader("Content-Type", m_content_type);
+    m_req->StartReply(m_status);
+    m_started = true;
+}
+
+bool HTTPReplyStream::Write(std::string piece)
+{
+    if (piece.empty()) return true;
+    bool delivering = true;
+    if (!m_held.empty()) {
+        if (!m_started) Start();
+        delivering = m_req->WriteReplyChunk(std::move(m_held));
+    }
+    m_held = std::move(piece);
+    return delivering;
+}
+
+void HTTPReplyStream::End(const std::string& tail)
+{
+    m_held += tail;
+    if (m_started) {
+        m_req->WriteReplyChunk(std::move(m_held));
+        m_req->EndReply();
+    } else {
+        m_req->WriteHeader("Content-Type", m_content_type);
+        m_req->WriteReply(m_status, m_held);
+    }
+}
+
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -45,11 +46,18 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run func(i) for every i below count, on up to max_threads HTTP worker threads at once.
+ * The calling thread takes part, and the call returns once all of them have returned.
+ */
+void HTTPRunParallel(size_t count, size_t max_threads, const std::function<void(size_t)>& func);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
 struct event_base* EventBase();
 
+struct HTTPReplyFlow;
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -58,6 +66,10 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    //! Whether a reply was started with StartReply and not yet ended
+    bool replyStreaming{false};
+    //! How much of the streamed reply still waits to be sent, shared with the main http thread
+    std::shared_ptr<HTTPReplyFlow> replyFlow;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -113,6 +125,66 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start an HTTP reply whose body follows in pieces, sent with chunked
+     * transfer encoding. Large replies are sent this way so they never have to
+     * be held in memory as a whole.
+     *
+     * @note Like WriteReply, this can be called only once, and only instead of
+     * WriteReply. Write the body with WriteReplyChunk and finish with EndReply.
+     */
+    void StartReply(int nStatus);
+
+    /**
+     * Send the next piece of a reply started with StartReply. While a lot of
+     * the reply still waits to be sent to a slow client, this waits for it to
+     * catch up. Returns false once the client went away or the node is shutting
+     * down, after which the rest of the reply needn't be produced. As it may
+     * block for long, never call it while holding a lock others may need.
+     */
+    bool WriteReplyChunk(std::string chunk);
+
+    /**
+     * Finish a reply started with StartReply. As this gives the request back
+     * to the main thread, do not call any other HTTPRequest methods after it.
+     */
+    void EndReply();
+
+    /**
+     * Cut short a reply started with StartReply, when the rest of the body
+     * can't be produced. The connection is closed without ending the chunked
+     * body, so the client can tell the reply is incomplete. As with EndReply,
+     * do not call any other HTTPRequest methods after it.
+     */
+    void AbortReply();
+};
+
+/**
+ * Sends a reply body that is produced piece by piece. The latest piece is held
+ * back, so a body that fits into one piece is sent as a plain reply, and an
+ * error found while producing the first piece can still be replied instead.
+ */
+class HTTPReplyStream
+{
+public:
+    HTTPReplyStream(HTTPRequest* req, int nStatus, const std::string& content_type);
+
+    /** Returns false if the reply can't be delivered any more, see HTTPRequest::WriteReplyChunk. */
+    bool Write(std::string piece);
+    /** Send what is held back, followed by tail, and finish the reply. */
+    void End(const std::string& tail = "");
+    /** Whether the reply was started, after which no other reply can be sent. */
+    bool Started() const { return m_started; }
+
+private:
+    void Start();
+
+    HTTPRequest* const m_req;
+    const int m_status;
+    const std::string m_content_type;
+    std::string m_held;
+    bool m_started{false};
 };
 
 /** Event handler closure.
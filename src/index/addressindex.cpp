@@ -0,0 +1,268 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <crypto/sha256.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The index database stores two records per output paying to a script, and one per input spending
+ * it. All keys start with the SHA256 hash of the scriptPubKey, so that the records of one script
+ * can be read with a single range scan.
+ *
+ * Keys for the history have the type [DB_ADDRESS_HISTORY, uint256, AddressHistoryPos], and
+ * hold the transaction, the output it created or spent and its amount.
+ * Keys for the unspent outputs have the type [DB_ADDRESS_UNSPENT, uint256, COutPoint], and hold
+ * the height, amount and coinbase flag of the output. They are erased when the output is spent.
+ *
+ * Blocks that are disconnected have their records erased in Rewind, and the records of the outputs
+ * they spent restored from the undo data.
+ */
+constexpr char DB_ADDRESS_HISTORY = 'h';
+constexpr char DB_ADDRESS_UNSPENT = 'u';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+namespace {
+
+struct DBHistoryKey {
+    uint256 script_hash;
+    AddressHistoryPos pos;
+
+    DBHistoryKey() {}
+    DBHistoryKey(const uint256& script_hash_in, const AddressHistoryPos& pos_in) : script_hash(script_hash_in), pos(pos_in) {}
+
+    SERIALIZE_METHODS(DBHistoryKey, obj) {
+        char prefix = DB_ADDRESS_HISTORY;
+        READWRITE(prefix);
+        if (prefix != DB_ADDRESS_HISTORY) {
+            throw std::ios_base::failure("Invalid format for address index DB history key");
+        }
+
+        READWRITE(obj.script_hash, obj.pos);
+    }
+};
+
+struct DBHistoryValue {
+    uint256 txid;
+    COutPoint outpoint;
+    CAmount amount{0};
+
+    SERIALIZE_METHODS(DBHistoryValue, obj) { READWRITE(obj.txid, obj.outpoint, obj.amount); }
+};
+
+struct DBUnspentKey {
+    uint256 script_hash;
+    COutPoint outpoint;
+
+    DBUnspentKey() {}
+    DBUnspentKey(const uint256& script_hash_in, const COutPoint& outpoint_in) : script_hash(script_hash_in), outpoint(outpoint_in) {}
+
+    SERIALIZE_METHODS(DBUnspentKey, obj) {
+        char prefix = DB_ADDRESS_UNSPENT;
+        READWRITE(prefix);
+        if (prefix != DB_ADDRESS_UNSPENT) {
+            throw std::ios_base::failure("Invalid format for address index DB unspent key");
+        }
+
+        READWRITE(obj.script_hash, obj.outpoint);
+    }
+};
+
+struct DBUnspentValue {
+    int height{0};
+    CAmount amount{0};
+    bool coinbase{false};
+
+    SERIALIZE_METHODS(DBUnspentValue, obj) { READWRITE(obj.height, obj.amount, obj.coinbase); }
+};
+
+}; // namespace
+
+/** Access to the address index database (indexes/addressindex/) */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+uint256 AddressIndex::HashScript(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+static bool CheckUndo(const CBlock& block, const CBlockUndo& block_undo)
+{
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block and undo data inconsistent", __func__);
+    }
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        if (block_undo.vtxundo[i - 1].vprevout.size() != block.vtx[i]->vin.size()) {
+            return error("%s: transaction and undo data inconsistent", __func__);
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::IndexBlock(const CBlock& block, const CBlockUndo& block_undo, int height)
+{
+    if (!CheckUndo(block, block_undo)) return false;
+
+    CDBBatch batch(*m_db);
+    for (uint32_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        if (i > 0) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout[j];
+                const uint256 script_hash = HashScript(coin.out.scriptPubKey);
+                batch.Write(DBHistoryKey(script_hash, {height, i, true, j}),
+                            DBHistoryValue{txid, tx.vin[j].prevout, coin.out.nValue});
+                batch.Erase(DBUnspentKey(script_hash, tx.vin[j].prevout));
+            }
+        }
+
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            // Like the UTXO set, leave out the outputs that can never be spent.
+            if (out.scriptPubKey.IsUnspendable()) continue;
+
+            const uint256 script_hash = HashScript(out.scriptPubKey);
+            const COutPoint outpoint(txid, j);
+            batch.Write(DBHistoryKey(script_hash, {height, i, false, j}),
+                        DBHistoryValue{txid, outpoint, out.nValue});
+            batch.Write(DBUnspentKey(script_hash, outpoint),
+                        DBUnspentValue{height, out.nValue, tx.IsCoinBase()});
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+/** Undo IndexBlock, working through the block in reverse so that outputs spent in it are restored last. */
+static bool EraseBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& block_undo, int height)
+{
+    if (!CheckUndo(block, block_undo)) return false;
+
+    for (uint32_t i = block.vtx.size(); i-- > 0;) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (out.scriptPubKey.IsUnspendable()) continue;
+
+            const uint256 script_hash = AddressIndex::HashScript(out.scriptPubKey);
+            batch.Erase(DBHistoryKey(script_hash, {height, i, false, j}));
+            batch.Erase(DBUnspentKey(script_hash, COutPoint(txid, j)));
+        }
+
+        if (i > 0) {
+            const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout[j];
+                const uint256 script_hash = AddressIndex::HashScript(coin.out.scriptPubKey);
+                batch.Erase(DBHistoryKey(script_hash, {height, i, true, j}));
+                batch.Write(DBUnspentKey(script_hash, tx.vin[j].prevout),
+                            DBUnspentValue{(int)coin.nHeight, coin.out.nValue, coin.IsCoinBase()});
+            }
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::UnindexBlock(const CBlock& block, const CBlockUndo& block_undo, int height)
+{
+    CDBBatch batch(*m_db);
+    if (!EraseBlock(batch, block, block_undo, height)) return false;
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Exclude genesis block outputs because they are not spendable.
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return error("%s: Failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    return IndexBlock(block, block_undo, pindex->nHeight);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // The disconnected blocks are erased newest first, in a single batch, so that the index is
+    // never left with only some of them undone.
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo block_undo;
+        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()) ||
+            !UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!EraseBlock(batch, block, block_undo, pindex->nHeight)) return false;
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool AddressIndex::FindHistory(const uint256& script_hash, const AddressHistoryPos& start, size_t max_count,
+                               std::vector<AddressHistoryEntry>& entries) const
+{
+    entries.clear();
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBHistoryKey key;
+    for (db_it->Seek(DBHistoryKey(script_hash, start)); db_it->Valid() && entries.size() < max_count; db_it->Next()) {
+        if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+
+        DBHistoryValue value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: Cannot parse address index history record", __func__);
+        }
+        entries.push_back({key.pos, value.txid, value.outpoint, value.amount});
+    }
+    return true;
+}
+
+bool AddressIndex::FindUnspent(const uint256& script_hash, const COutPoint& start, size_t max_count,
+                               std::vector<AddressUnspent>& unspent) const
+{
+    unspent.clear();
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBUnspentKey key;
+    for (db_it->Seek(DBUnspentKey(script_hash, start)); db_it->Valid() && unspent.size() < max_count; db_it->Next()) {
+        if (!db_it->GetKey(key) || key.script_hash != script_hash) break;
+
+        DBUnspentValue value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: Cannot parse address index unspent record", __func__);
+        }
+        unspent.push_back({key.outpoint, value.height, value.amount, value.coinbase});
+    }
+    return true;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <serialize.h>
+
+class CBlockUndo;
+class CScript;
+
+/**
+ * Position of an entry in the history of a script. Entries are ordered by
+ * block height, then by position of the transaction in the block, with the
+ * outputs a transaction spends ahead of the outputs it creates.
+ */
+struct AddressHistoryPos {
+    int height{0};
+    //! Position of the transaction in its block
+    uint32_t tx_pos{0};
+    //! Whether the transaction spent the output, rather than created it
+    bool spend{true};
+    //! Index of the input spending the output, or of the output itself
+    uint32_t index{0};
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        // Big-endian, so that the database keeps each history in order
+        ser_writedata32be(s, height);
+        ser_writedata32be(s, tx_pos);
+        ser_writedata8(s, spend ? 0 : 1);
+        ser_writedata32be(s, index);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        height = ser_readdata32be(s);
+        tx_pos = ser_readdata32be(s);
+        spend = ser_readdata8(s) == 0;
+        index = ser_readdata32be(s);
+    }
+};
+
+/** A transaction that created or spent an output paying to an indexed script. */
+struct AddressHistoryEntry {
+    AddressHistoryPos pos;
+    uint256 txid;
+    //! The output that was created or spent
+    COutPoint outpoint;
+    CAmount amount{0};
+};
+
+/** An unspent output paying to an indexed script. */
+struct AddressUnspent {
+    COutPoint outpoint;
+    int height{0};
+    CAmount amount{0};
+    bool coinbase{false};
+};
+
+/**
+ * AddressIndex is used to look up the transparent outputs paying to a script
+ * and the transactions spending them. The index is written to a LevelDB
+ * database and records, by the SHA256 hash of each scriptPubKey, the outputs
+ * created and spent in the active chain, and the outputs still unspent.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    bool RewindOnDisconnect() const override { return true; }
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// The hash under which the index files a scriptPubKey.
+    static uint256 HashScript(const CScript& script);
+
+    /// Add the entries of a block connected at the given height.
+    ///
+    /// @param[in]  block_undo  The coins spent by the block's transactions.
+    /// @return  true on success, false on a database error or inconsistent undo data
+    bool IndexBlock(const CBlock& block, const CBlockUndo& block_undo, int height);
+
+    /// Remove the entries of a block disconnected at the given height, restoring the outputs it
+    /// spent. This is the reverse of IndexBlock.
+    ///
+    /// @return  true on success, false on a database error or inconsistent undo data
+    bool UnindexBlock(const CBlock& block, const CBlockUndo& block_undo, int height);
+
+    /// Look up the history of a script.
+    ///
+    /// @param[in]   script_hash  The hash of the script, see HashScript.
+    /// @param[in]   start  The position of the first entry to return.
+    /// @param[in]   max_count  The maximum number of entries to return.
+    /// @param[out]  entries  The entries from start onwards, oldest first.
+    /// @return  true on success, false on a database error
+    bool FindHistory(const uint256& script_hash, const AddressHistoryPos& start, size_t max_count,
+                     std::vector<AddressHistoryEntry>& entries) const;
+
+    /// Look up the unspent outputs paying to a script.
+    ///
+    /// @param[in]   script_hash  The hash of the script, see HashScript.
+    /// @param[in]   start  The outpoint to start from; outputs are ordered by their serialized outpoint.
+    /// @param[in]   max_count  The maximum number of outputs to return.
+    /// @param[out]  unspent  The unspent outputs from start onwards.
+    /// @return  true on success, false on a database error
+    bool FindUnspent(const uint256& script_hash, const COutPoint& start, size_t max_count,
+                     std::vector<AddressUnspent>& unspent) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -229,6 +229,25 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
     }
 }
 
+void BaseIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    if (!m_synced || !RewindOnDisconnect()) {
+        return;
+    }
+
+    // If the index is not at the disconnected block, it has not caught up with the block
+    // notifications yet, and BlockConnected rewinds it as needed.
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (best_block_index != pindex) {
+        return;
+    }
+
+    if (!Rewind(best_block_index, pindex->pprev)) {
+        FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                   __func__, GetName());
+    }
+}
+
 void BaseIndex::ChainStateFlushed(const CBlockLocator& locator)
 {
     if (!m_synced) {
@@ -278,11 +297,14 @@ bool BaseIndex::BlockUntilSyncedToCurrentChain() const
 
     {
         // Skip the queue-draining stuff if we know we're caught up with
-        // ::ChainActive().Tip().
+        // ::ChainActive().Tip(). An index that rewinds on disconnected blocks
+        // and is ahead of the tip still has to process their notifications.
         LOCK(cs_main);
         const CBlockIndex* chain_tip = ::ChainActive().Tip();
         const CBlockIndex* best_block_index = m_best_block_index.load();
-        if (best_block_index->GetAncestor(chain_tip->nHeight) == chain_tip) {
+        const bool caught_up = RewindOnDisconnect() ? best_block_index == chain_tip
+                                                    : best_block_index->GetAncestor(chain_tip->nHeight) == chain_tip;
+        if (caught_up) {
             return true;
         }
     }
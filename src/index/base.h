@@ -79,6 +79,9 @@ private:
 protected:
     void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
 
+    /// Rewind the index past a block disconnected from its tip, if RewindOnDisconnect is set.
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
     void ChainStateFlushed(const CBlockLocator& locator) override;
 
     /// Initialize internal state from the database and block index.
@@ -95,6 +98,11 @@ protected:
     /// be an ancestor of the current best block.
     virtual bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
 
+    /// Whether the index is rewound as soon as a block is disconnected from its tip, so that
+    /// lookups don't return entries of blocks that left the active chain. Other indexes are
+    /// rewound when the next block of the new chain gets connected.
+    virtual bool RewindOnDisconnect() const { return false; }
+
     virtual DB& GetDB() const = 0;
 
     /// Get the name of the index for display in logs.
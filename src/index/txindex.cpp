@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chainparams.h>
 #include <index/disktxpos.h>
 #include <index/txindex.h>
 #include <node/ui_interface.h>
@@ -235,17 +236,39 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
         return false;
     }
 
-    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    FlatFilePos hpos = postx;
+    hpos.nPos -= 8; // Seek back 8 bytes for the record header
+    CAutoFile file(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
     if (file.IsNull()) {
         return error("%s: OpenBlockFile failed", __func__);
     }
     CBlockHeader header;
     try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+        file >> blk_start >> blk_size;
+        if (IsCompressedRecord(blk_start, Params().MessageStart())) {
+            // Compressed blocks can only be decompressed as a whole.
+            if (blk_size > MAX_SIZE) {
+                return error("%s: Compressed block is too large", __func__);
+            }
+            std::vector<uint8_t> frame(blk_size);
+            std::vector<uint8_t> data;
+            file.read((char*)frame.data(), frame.size());
+            if (!DecompressRecord(frame, data)) {
+                return error("%s: Compressed block is corrupt", __func__);
+            }
+            VectorReader reader(SER_DISK, CLIENT_VERSION, data, 0);
+            reader >> header;
+            VectorReader tx_reader(SER_DISK, CLIENT_VERSION, data, ::GetSerializeSize(header, CLIENT_VERSION) + postx.nTxOffset);
+            tx_reader >> tx;
+        } else {
+            file >> header;
+            if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
+                return error("%s: fseek(...) failed", __func__);
+            }
+            file >> tx;
         }
-        file >> tx;
     } catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
@@ -71,6 +71,16 @@ private:
 extern mw::Hash Hashed(const std::vector<uint8_t>& serialized);
 extern mw::Hash Hashed(const Traits::ISerializable& serializable);
 
+//
+// Hashes the serialization of the object by streaming it directly into the hasher,
+// rather than first building a byte vector using ISerializable::Serialized().
+//
+template<class T>
+mw::Hash Hashed(const T& serializable)
+{
+    return Hasher().Append(serializable).hash();
+}
+
 template<class T>
 mw::Hash Hashed(const EHashTag tag, const T& serializable)
 {
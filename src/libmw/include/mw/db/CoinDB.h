@@ -7,6 +7,33 @@
 // Forward Declarations
 class Database;
 
+//
+// Iterates over every UTXO in the database, ordered by output ID.
+// Reads from the snapshot of the database taken when the cursor was created,
+// so it's unaffected by any writes that happen while iterating.
+//
+class UTXOCursor
+{
+public:
+	using UPtr = std::unique_ptr<UTXOCursor>;
+
+	UTXOCursor(std::unique_ptr<mw::DBIterator>&& pIter, const char prefix)
+		: m_pIter(std::move(pIter)), m_prefix(prefix) { }
+
+	bool Valid() const;
+	void Next() { m_pIter->Next(); }
+
+	//
+	// Returns the UTXO at the current position.
+	// DeserializationException thrown if the entry can't be read.
+	//
+	UTXO::CPtr Get() const;
+
+private:
+	std::unique_ptr<mw::DBIterator> m_pIter;
+	char m_prefix;
+};
+
 class CoinDB
 {
 public:
@@ -41,6 +68,11 @@ public:
 	//
 	void RemoveAllUTXOs();
 
+	//
+	// Creates a cursor for iterating over all of the UTXOs in the database.
+	//
+	UTXOCursor::UPtr GetCursor() const;
+
 private:
 	std::unique_ptr<Database> m_pDatabase;
 };
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <mw/models/crypto/Hash.h>
 #include <mw/mmr/LeafIndex.h>
 #include <mw/mmr/Leaf.h>
+#include <mw/mmr/MMRProof.h>
 #include <mw/mmr/PruneList.h>
 #include <mw/interfaces/db_interface.h>
 
@@ -79,6 +80,14 @@ public:
     /// <returns>The root hash of the MMR.</returns>
     mw::Hash Root() const;
 
+    /// <summary>
+    /// Builds a proof that the given leaves are included in the MMR, which can be verified against Root().
+    /// </summary>
+    /// <param name="leaves">The leaves to prove. Duplicates are removed.</param>
+    /// <returns>The MMRProof, with the leaves sorted in ascending order.</returns>
+    /// <throws>std::exception if a leaf is beyond the end of the MMR.</throws>
+    MMRProof BuildProof(std::vector<mmr::LeafIndex> leaves) const;
+
     /// <summary>
     /// Adds the given leaves to the MMR.
     /// This also updates the database and MMR files when the MMR is not a cache.
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mw/common/Traits.h>
+#include <mw/models/crypto/Hash.h>
+#include <mw/mmr/LeafIndex.h>
+#include <boost/optional.hpp>
+#include <serialize.h>
+#include <vector>
+
+/// <summary>
+/// Proves the inclusion of one or more leaves in an MMR with a given number of leaves.
+/// When proving multiple leaves, sibling hashes shared by their paths are only included once,
+/// and hashes that can be computed from the proven leaves are left out entirely.
+/// </summary>
+class MMRProof : public Traits::ISerializable
+{
+public:
+    MMRProof() : m_numLeaves(0) { }
+    MMRProof(const uint64_t num_leaves, std::vector<mmr::LeafIndex> leaves, std::vector<mw::Hash> hashes)
+        : m_numLeaves(num_leaves), m_leaves(std::move(leaves)), m_hashes(std::move(hashes)) { }
+
+    /// <summary>
+    /// Calculates the positions of the hashes a proof for the given leaves must include.
+    /// </summary>
+    /// <param name="num_leaves">The total number of leaves in the MMR.</param>
+    /// <param name="leaves">The leaves being proven, sorted in ascending order with no duplicates.</param>
+    /// <returns>The positions of the required hashes, sorted in ascending order.</returns>
+    static std::vector<mmr::Index> CalcProofPositions(const uint64_t num_leaves, const std::vector<mmr::LeafIndex>& leaves);
+
+    /// <summary>
+    /// Calculates the root of the MMR from the hashes of the proven leaves.
+    /// </summary>
+    /// <param name="leaf_hashes">The hashes of the leaves, in the same order as GetLeaves().</param>
+    /// <returns>The calculated root, or boost::none if the proof is malformed.</returns>
+    boost::optional<mw::Hash> CalcRoot(const std::vector<mw::Hash>& leaf_hashes) const;
+
+    bool Verify(const mw::Hash& root, const std::vector<mw::Hash>& leaf_hashes) const
+    {
+        auto calculated = CalcRoot(leaf_hashes);
+        return calculated && *calculated == root;
+    }
+
+    uint64_t GetNumLeaves() const noexcept { return m_numLeaves; }
+    const std::vector<mmr::LeafIndex>& GetLeaves() const noexcept { return m_leaves; }
+    const std::vector<mw::Hash>& GetHashes() const noexcept { return m_hashes; }
+
+    IMPL_SERIALIZABLE(MMRProof, obj)
+    {
+        READWRITE(VARINT(obj.m_numLeaves), obj.m_leaves, obj.m_hashes);
+    }
+
+private:
+    uint64_t m_numLeaves;
+    std::vector<mmr::LeafIndex> m_leaves;
+    std::vector<mw::Hash> m_hashes;
+};
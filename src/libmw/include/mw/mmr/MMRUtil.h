@@ -19,6 +19,21 @@ public:
     /// <param name="unspent_leaf_indices">The unspent leaf indices.</param>
     /// <returns>The pruned parent positions.</returns>
     static BitSet CalcPrunedParents(const BitSet& unspent_leaf_indices);
+
+    /// <summary>
+    /// Calculates the positions of the "peaks" (nodes with no parents) of an MMR with the given number of nodes.
+    /// </summary>
+    /// <param name="num_nodes">The total number of nodes in the MMR.</param>
+    /// <returns>The peak indices, ordered from left to right.</returns>
+    static std::vector<mmr::Index> CalcPeaks(const uint64_t num_nodes);
+
+    /// <summary>
+    /// "Bags" the peaks by hashing them iteratively from the right, using the total size of the MMR as prefix.
+    /// </summary>
+    /// <param name="num_nodes">The total number of nodes in the MMR.</param>
+    /// <param name="peak_hashes">The hashes of the peaks, ordered from left to right.</param>
+    /// <returns>The root hash of the MMR.</returns>
+    static mw::Hash BagPeaks(const uint64_t num_nodes, const std::vector<mw::Hash>& peak_hashes);
 };
 
 /// <summary>
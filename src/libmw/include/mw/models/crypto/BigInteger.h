@@ -27,11 +27,10 @@ public:
     //
     // Constructors
     //
-    BigInt() noexcept : m_bytes(NUM_BYTES) { }
-    BigInt(const std::vector<uint8_t, ALLOC>& bytes) : m_bytes(bytes) { assert(m_bytes.size() == NUM_BYTES); }
-    BigInt(std::vector<uint8_t, ALLOC>&& bytes) : m_bytes(std::move(bytes)) { assert(m_bytes.size() == NUM_BYTES); }
-    BigInt(const std::array<uint8_t, NUM_BYTES>& bytes) : m_bytes(bytes.cbegin(), bytes.cend()) { }
-    explicit BigInt(const uint8_t* arr) : m_bytes(arr, arr + NUM_BYTES) { }
+    BigInt() noexcept : m_bytes{} { }
+    BigInt(const std::vector<uint8_t, ALLOC>& bytes) { assert(bytes.size() == NUM_BYTES); std::copy_n(bytes.cbegin(), NUM_BYTES, m_bytes.begin()); }
+    BigInt(const std::array<uint8_t, NUM_BYTES>& bytes) : m_bytes(bytes) { }
+    explicit BigInt(const uint8_t* arr) { std::copy_n(arr, NUM_BYTES, m_bytes.begin()); }
     BigInt(const BigInt& bigInteger) = default;
     BigInt(BigInt&& bigInteger) noexcept = default;
 
@@ -47,12 +46,11 @@ public:
     }
 
     static size_t size() noexcept { return NUM_BYTES; }
-    const std::vector<uint8_t, ALLOC>& vec() const { return m_bytes; }
+    std::vector<uint8_t, ALLOC> vec() const { return std::vector<uint8_t, ALLOC>(m_bytes.cbegin(), m_bytes.cend()); }
     uint8_t* data() { return m_bytes.data(); }
     const uint8_t* data() const { return m_bytes.data(); }
     bool IsZero() const noexcept
     {
-        assert(m_bytes.size() == NUM_BYTES);
         for (uint8_t byte : m_bytes)
         {
             if (byte != 0) {
@@ -65,9 +63,9 @@ public:
 
     static BigInt<NUM_BYTES, ALLOC> ValueOf(const uint8_t value)
     {
-        std::vector<uint8_t, ALLOC> bytes(NUM_BYTES);
-        bytes[NUM_BYTES - 1] = value;
-        return BigInt<NUM_BYTES, ALLOC>(std::move(bytes));
+        BigInt<NUM_BYTES, ALLOC> result;
+        result[NUM_BYTES - 1] = value;
+        return result;
     }
 
     static BigInt<NUM_BYTES, ALLOC> FromHex(const std::string& hex)
@@ -80,21 +78,12 @@ public:
 
     static BigInt<NUM_BYTES, ALLOC> Max()
     {
-        std::vector<uint8_t, ALLOC> bytes(NUM_BYTES);
-        for (size_t i = 0; i < NUM_BYTES; i++)
-        {
-            bytes[i] = 0xFF;
-        }
-
-        return BigInt<NUM_BYTES, ALLOC>(std::move(bytes));
+        BigInt<NUM_BYTES, ALLOC> result;
+        result.m_bytes.fill(0xFF);
+        return result;
     }
 
-    std::array<uint8_t, NUM_BYTES> ToArray() const noexcept
-    {
-        std::array<uint8_t, NUM_BYTES> arr;
-        std::copy_n(m_bytes.begin(), NUM_BYTES, arr.begin());
-        return arr;
-    }
+    const std::array<uint8_t, NUM_BYTES>& ToArray() const noexcept { return m_bytes; }
 
     std::string ToHex() const noexcept { return HexStr(m_bytes); }
     std::string Format() const noexcept final { return ToHex(); }
@@ -126,7 +115,6 @@ public:
             return false;
         }
 
-        assert(m_bytes.size() == NUM_BYTES && rhs.m_bytes.size() == NUM_BYTES);
         for (size_t i = 0; i < NUM_BYTES; i++)
         {
             if (m_bytes[i] != rhs.m_bytes[i])
@@ -188,5 +176,6 @@ public:
     }
 
 private:
-    std::vector<uint8_t, ALLOC> m_bytes;
+    // Stored inline so that deserializing hashes, commitments, keys and signatures doesn't hit the heap.
+    std::array<uint8_t, NUM_BYTES> m_bytes;
 };
\ No newline at end of file
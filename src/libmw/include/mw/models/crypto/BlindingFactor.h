@@ -41,7 +41,7 @@ public:
     // Getters
     //
     const BigInt<32>& GetBigInt() const noexcept { return m_value; }
-    const std::vector<uint8_t>& vec() const noexcept { return m_value.vec(); }
+    std::vector<uint8_t> vec() const noexcept { return m_value.vec(); }
     std::array<uint8_t, 32> array() const noexcept { return m_value.ToArray(); }
     const uint8_t* data() const noexcept { return m_value.data(); }
     uint8_t* data() noexcept { return m_value.data(); }
@@ -57,7 +57,7 @@ public:
     // Getters
     //
     const BigInt<SIZE>& GetBigInt() const noexcept { return m_bytes; }
-    const std::vector<uint8_t>& vec() const noexcept { return m_bytes.vec(); }
+    std::vector<uint8_t> vec() const noexcept { return m_bytes.vec(); }
     std::array<uint8_t, SIZE> array() const noexcept { return m_bytes.ToArray(); }
     const uint8_t* data() const noexcept { return m_bytes.data(); }
     uint8_t* data() noexcept { return m_bytes.data(); }
@@ -91,7 +91,7 @@ namespace std
     {
         size_t operator()(const Commitment& commitment) const
         {
-            return boost::hash_value(commitment.vec());
+            return boost::hash_range(commitment.data(), commitment.data() + commitment.size());
         }
     };
 } // namespace std
@@ -22,7 +22,7 @@ namespace std
     {
         size_t operator()(const mw::Hash& hash) const
         {
-            return boost::hash_value(hash.vec());
+            return boost::hash_range(hash.data(), hash.data() + hash.size());
         }
     };
 }
@@ -49,7 +49,7 @@ public:
     const BigInt<33>& GetBigInt() const { return m_compressed; }
     CKeyID GetID() const { return CPubKey(vec()).GetID(); }
     std::array<uint8_t, 33> array() const { return m_compressed.ToArray(); }
-    const std::vector<uint8_t>& vec() const { return m_compressed.vec(); }
+    std::vector<uint8_t> vec() const { return m_compressed.vec(); }
     const uint8_t& operator[](const size_t x) const { return m_compressed[x]; }
     const uint8_t* data() const { return m_compressed.data(); }
     uint8_t* data() { return m_compressed.data(); }
@@ -87,7 +87,7 @@ namespace std
     {
         size_t operator()(const PublicKey& pubkey) const
         {
-            return boost::hash_value(pubkey.vec());
+            return boost::hash_range(pubkey.data(), pubkey.data() + pubkey.size());
         }
     };
 }
\ No newline at end of file
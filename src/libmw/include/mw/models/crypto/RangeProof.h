@@ -8,6 +8,8 @@
 #include <mw/crypto/Hasher.h>
 #include <util/strencodings.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 
 class RangeProof :
@@ -22,10 +24,11 @@ public:
     //
     // Constructors
     //
-    RangeProof() noexcept : m_bytes(SIZE) {}
-    RangeProof(std::vector<uint8_t>&& bytes) : m_bytes(std::move(bytes))
+    RangeProof() noexcept : m_bytes{} {}
+    RangeProof(const std::vector<uint8_t>& bytes)
     {
-        assert(m_bytes.size() == SIZE);
+        assert(bytes.size() == SIZE);
+        std::copy_n(bytes.cbegin(), SIZE, m_bytes.begin());
         m_hash = Hashed(*this);
     }
     RangeProof(const RangeProof& other) = default;
@@ -46,7 +49,7 @@ public:
     //
     // Getters
     //
-    const std::vector<uint8_t>& vec() const { return m_bytes; }
+    std::vector<uint8_t> vec() const { return std::vector<uint8_t>(m_bytes.cbegin(), m_bytes.cend()); }
     const uint8_t* data() const { return m_bytes.data(); }
     size_t size() const { return m_bytes.size(); }
 
@@ -76,8 +79,9 @@ public:
     const mw::Hash& GetHash() const noexcept final { return m_hash; }
 
 private:
-    // The proof itself, at most 675 bytes long.
-    std::vector<uint8_t> m_bytes;
+    // The proof itself, 675 bytes long.
+    // Stored inline so the proof lives in the same allocation as its shared_ptr control block.
+    std::array<uint8_t, SIZE> m_bytes;
 
     mw::Hash m_hash;
 };
@@ -43,7 +43,7 @@ public:
     // Getters
     //
     const BigInt<SIZE>& GetBigInt() const { return m_bytes; }
-    const std::vector<uint8_t>& vec() const { return m_bytes.vec(); }
+    std::vector<uint8_t> vec() const { return m_bytes.vec(); }
     const uint8_t* data() const { return m_bytes.data(); }
     uint8_t* data() { return m_bytes.data(); }
 
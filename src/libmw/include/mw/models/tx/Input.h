@@ -37,6 +37,7 @@ public:
         m_outputPubKey(std::move(output_pubkey)),
         m_signature(std::move(signature))
     {
+        m_sigMessage = ComputeSignatureMessage();
         m_hash = Hashed(*this);
     }
     Input(const Input& input) = default;
@@ -96,6 +97,7 @@ public:
         }
 
         READWRITE(obj.m_signature);
+        SER_READ(obj, obj.m_sigMessage = obj.ComputeSignatureMessage());
         SER_READ(obj, obj.m_hash = Hashed(obj));
     }
 
@@ -106,6 +108,8 @@ public:
     const mw::Hash& GetHash() const noexcept final { return m_hash; }
 
 private:
+    mw::Hash ComputeSignatureMessage() const noexcept;
+
     uint8_t m_features;
 
     // The ID of the output being spent.
@@ -124,6 +128,8 @@ private:
 
     Signature m_signature;
 
+    // The message signed by m_signature. Computed once, alongside m_hash.
+    mw::Hash m_sigMessage;
     mw::Hash m_hash;
 };
 
@@ -40,6 +40,7 @@ public:
         m_excess(std::move(excess)),
         m_signature(std::move(signature))
     {
+        m_sigMessage = ComputeSignatureMessage();
         m_hash = Hashed(*this);
     }
 
@@ -188,6 +189,7 @@ public:
 
         s >> m_excess >> m_signature;
 
+        m_sigMessage = ComputeSignatureMessage();
         m_hash = Hashed(*this);
     }
 
@@ -198,6 +200,8 @@ public:
     const Commitment& GetCommitment() const noexcept final { return m_excess; }
 
 private:
+    mw::Hash ComputeSignatureMessage() const;
+
     uint8_t m_features;
     boost::optional<CAmount> m_fee;
     boost::optional<CAmount> m_pegin;
@@ -213,6 +217,8 @@ private:
     // The signature proving the excess is a valid public key, which signs the transaction fee.
     Signature m_signature;
 
+    // The message signed by m_signature. Computed once, alongside m_hash.
+    mw::Hash m_sigMessage;
     mw::Hash m_hash;
 };
 
@@ -118,7 +118,7 @@ public:
         m_pProof(pProof),
         m_signature(std::move(signature))
     {
-        m_hash = ComputeHash();
+        ComputeHashes();
     }
 
     Output(const Output& Output) = default;
@@ -185,7 +185,7 @@ public:
         READWRITE(obj.m_message);
         READWRITE(obj.m_pProof);
         READWRITE(obj.m_signature);
-        SER_READ(obj, obj.m_hash = obj.ComputeHash());
+        SER_READ(obj, obj.ComputeHashes());
     }
 
     //
@@ -201,16 +201,19 @@ private:
     // 
     // This will make some light client use cases more efficient.
     //
-    mw::Hash ComputeHash() const noexcept
+    // The message signed by the sender is a prefix of that same serialization,
+    // so the output ID and the signature message are computed together.
+    //
+    void ComputeHashes() noexcept
     {
-        return Hasher()
-            .Append(m_commitment)
+        Hasher hasher;
+        hasher.Append(m_commitment)
             .Append(m_senderPubKey)
             .Append(m_receiverPubKey)
             .Append(m_message.GetHash())
-            .Append(m_pProof->GetHash())
-            .Append(m_signature)
-            .hash();
+            .Append(m_pProof->GetHash());
+        m_sigMessage = Hasher(hasher).hash();
+        m_hash = hasher.Append(m_signature).hash();
     }
 
     Commitment m_commitment;
@@ -220,6 +223,7 @@ private:
     RangeProof::CPtr m_pProof;
     Signature m_signature;
 
+    mw::Hash m_sigMessage;
     mw::Hash m_hash;
 };
 
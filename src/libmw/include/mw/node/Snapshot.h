@@ -0,0 +1,133 @@
+#pragma once
+
+#include <mw/common/BitSet.h>
+#include <mw/common/Macros.h>
+#include <mw/db/CoinDB.h>
+#include <mw/exceptions/DatabaseException.h>
+#include <mw/file/FilePath.h>
+#include <mw/node/CoinsView.h>
+#include <functional>
+
+MW_NAMESPACE
+
+//
+// An MWEB UTXO snapshot is streamed in 3 parts:
+// 1. The leafset bitmap, with one bit per TXO in the output PMMR.
+// 2. The hashes of the output PMMR nodes that can't be compacted, in order of position.
+//    A node is compacted when its whole subtree is spent (see MMRUtil::BuildCompactBitSet),
+//    so the number of hashes scales with the size of the UTXO set instead of with the number of TXOs.
+// 3. One UTXO for every leaf in the leafset, ordered by output ID.
+//
+// The header the snapshot was taken at is not part of the stream.
+// It's expected to be committed to by whatever wraps the snapshot (ie. the block it was taken at).
+//
+
+class SnapshotWriter
+{
+public:
+    //
+    // Captures the leafset and output PMMR of the DB view, and opens a DB snapshot to read the UTXOs from.
+    // The caller must prevent the view from being flushed while this is being constructed,
+    // but since everything is captured up front, that's no longer necessary when calling Write.
+    //
+    explicit SnapshotWriter(const ICoinsView::Ptr& pView);
+
+    const mw::Header::CPtr& GetHeader() const noexcept { return m_pHeader; }
+    uint64_t GetNumUTXOs() const noexcept { return m_leafset.count(); }
+
+    template <typename Stream>
+    void Write(Stream& s, const std::function<void()>& interruption_point = [] {})
+    {
+        s << m_leafset;
+        for (const mw::Hash& hash : m_hashes) {
+            s << hash;
+        }
+
+        uint64_t num_written = 0;
+        for (; m_pCursor->Valid(); m_pCursor->Next()) {
+            if (num_written % 5000 == 0) interruption_point();
+            s << *m_pCursor->Get();
+            ++num_written;
+        }
+
+        if (num_written != GetNumUTXOs()) {
+            ThrowDatabase_F("Expected {} UTXOs, but found {}", GetNumUTXOs(), num_written);
+        }
+    }
+
+private:
+    mw::Header::CPtr m_pHeader;
+    BitSet m_leafset;
+    std::vector<mw::Hash> m_hashes;
+    UTXOCursor::UPtr m_pCursor;
+};
+
+class SnapshotLoader
+{
+public:
+    //
+    // Prepares to load a snapshot taken at the given header into an empty datadir & database.
+    // DatabaseException thrown if MWEB state already exists.
+    //
+    SnapshotLoader(const FilePath& datadir, const mw::DBWrapper::Ptr& pDBWrapper, const mw::Header::CPtr& pHeader);
+
+    //
+    // Reads the snapshot from the stream, verifying it against the header as it goes.
+    // Returns the DB view of the loaded UTXO set, which can be used like one opened with CoinsViewDB::Open.
+    // ValidationException thrown if the snapshot doesn't match the header.
+    //
+    template <typename Stream>
+    CoinsViewDB::Ptr Load(Stream& s, const std::function<void()>& interruption_point = [] {})
+    {
+        BitSet leafset;
+        s >> leafset;
+        const uint64_t num_hashes = LoadLeafSet(std::move(leafset));
+
+        std::vector<mw::Hash> hashes;
+        hashes.reserve(HASH_CHUNK_SIZE);
+        for (uint64_t i = 0; i < num_hashes; i++) {
+            hashes.emplace_back();
+            s >> hashes.back();
+
+            if (hashes.size() == HASH_CHUNK_SIZE) {
+                AddHashes(hashes);
+                hashes.clear();
+            }
+        }
+
+        AddHashes(hashes);
+        OpenOutputPMMR();
+
+        for (uint64_t i = 0; i < m_leafset.count(); i++) {
+            if (i % 5000 == 0) interruption_point();
+
+            auto pUTXO = std::make_shared<UTXO>();
+            s >> *pUTXO;
+            AddUTXO(pUTXO);
+        }
+
+        return Finish();
+    }
+
+private:
+    static constexpr size_t HASH_CHUNK_SIZE = 4096;
+    static constexpr size_t UTXO_BATCH_SIZE = 10000;
+
+    uint64_t LoadLeafSet(BitSet&& leafset);
+    void AddHashes(const std::vector<mw::Hash>& hashes);
+    void OpenOutputPMMR();
+    void AddUTXO(const UTXO::CPtr& pUTXO);
+    void WriteUTXOs();
+    CoinsViewDB::Ptr Finish();
+
+    FilePath m_datadir;
+    mw::DBWrapper::Ptr m_pDatabase;
+    mw::Header::CPtr m_pHeader;
+
+    BitSet m_leafset;
+    BitSet m_loaded;
+    PMMR::Ptr m_pOutputPMMR;
+    std::vector<UTXO::CPtr> m_utxos;
+};
+
+END_NAMESPACE
@@ -1,4 +1,5 @@
 #include <mw/db/CoinDB.h>
+#include <mw/exceptions/DeserializationException.h>
 #include "common/Database.h"
 
 static const DBTable UTXO_TABLE = { 'U' };
@@ -44,4 +45,27 @@ void CoinDB::RemoveUTXOs(const std::vector<mw::Hash>& output_ids)
 void CoinDB::RemoveAllUTXOs()
 {
     m_pDatabase->DeleteAll(UTXO_TABLE);
-}
\ No newline at end of file
+}
+UTXOCursor::UPtr CoinDB::GetCursor() const
+{
+    // UTXOs are keyed by output ID hex, so the zero hash is the smallest key.
+    return std::make_unique<UTXOCursor>(m_pDatabase->NewIterator(UTXO_TABLE, mw::Hash().ToHex()), UTXO_TABLE.GetPrefix());
+}
+
+bool UTXOCursor::Valid() const
+{
+    std::string key;
+    return m_pIter->Valid() && m_pIter->GetKey(key) && !key.empty() && key.front() == m_prefix;
+}
+
+UTXO::CPtr UTXOCursor::Get() const
+{
+    std::vector<uint8_t> value;
+    if (!m_pIter->GetValue(value)) {
+        ThrowDeserialization("Failed to read UTXO");
+    }
+
+    auto pUTXO = std::make_shared<UTXO>();
+    CDataStream(value, SER_DISK, PROTOCOL_VERSION) >> *pUTXO;
+    return pUTXO;
+}
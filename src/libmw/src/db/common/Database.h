@@ -72,6 +72,19 @@ public:
         }
     }
 
+    //
+    // Returns an iterator positioned at the given key, or at the first key after it.
+    // NOTE: Keys are serialized with a length prefix, so entries are ordered by key length first.
+    // To iterate over a table, first_key must be the smallest key of the length used by the table.
+    // The caller is responsible for stopping once the key prefix no longer matches.
+    //
+    std::unique_ptr<mw::DBIterator> NewIterator(const DBTable& table, const std::string& first_key) const
+    {
+        auto pIter = m_pDB->NewIterator();
+        pIter->Seek(table.BuildKey(first_key));
+        return pIter;
+    }
+
     void DeleteAll(const DBTable& table)
     {
         auto pBatch = m_pDB->CreateBatch();
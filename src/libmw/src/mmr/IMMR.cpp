@@ -1,5 +1,8 @@
 #include <mw/mmr/MMR.h>
 #include <mw/mmr/MMRUtil.h>
+#include <mw/exceptions/NotFoundException.h>
+
+#include <algorithm>
 
 using namespace mmr;
 
@@ -10,34 +13,28 @@ mw::Hash IMMR::Root() const
         return mw::Hash{};
     }
 
-    // Find the "peaks"
-    std::vector<uint64_t> peakIndices;
+    std::vector<mw::Hash> peak_hashes;
+    for (const Index& peak : MMRUtil::CalcPeaks(num_nodes)) {
+        peak_hashes.push_back(GetHash(peak));
+    }
+
+    return MMRUtil::BagPeaks(num_nodes, peak_hashes);
+}
 
-    uint64_t peakSize = BitUtil::FillOnesToRight(num_nodes);
-    uint64_t numLeft = num_nodes;
-    uint64_t sumPrevPeaks = 0;
-    while (peakSize != 0) {
-        if (numLeft >= peakSize) {
-            peakIndices.push_back(sumPrevPeaks + peakSize - 1);
-            sumPrevPeaks += peakSize;
-            numLeft -= peakSize;
-        }
+MMRProof IMMR::BuildProof(std::vector<mmr::LeafIndex> leaves) const
+{
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
 
-        peakSize >>= 1;
+    const uint64_t num_leaves = GetNumLeaves();
+    if (!leaves.empty() && leaves.back().Get() >= num_leaves) {
+        ThrowNotFound_F("Can't prove leaf {} of {}", leaves.back().Get(), num_leaves);
     }
 
-    assert(numLeft == 0);
-
-    // Bag 'em
-    mw::Hash hash;
-    for (auto iter = peakIndices.crbegin(); iter != peakIndices.crend(); iter++) {
-        mw::Hash peakHash = GetHash(Index::At(*iter));
-        if (hash.IsZero()) {
-            hash = peakHash;
-        } else {
-            hash = MMRUtil::CalcParentHash(Index::At(num_nodes), peakHash, hash);
-        }
+    std::vector<mw::Hash> hashes;
+    for (const Index& idx : MMRProof::CalcProofPositions(num_leaves, leaves)) {
+        hashes.push_back(GetHash(idx));
     }
 
-    return hash;
-}
\ No newline at end of file
+    return MMRProof(num_leaves, std::move(leaves), std::move(hashes));
+}
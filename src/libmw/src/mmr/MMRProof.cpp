@@ -0,0 +1,118 @@
+#include <mw/mmr/MMRProof.h>
+#include <mw/mmr/MMRUtil.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+using namespace mmr;
+
+// Collects the positions of every node on the paths from the leaves up to their peaks.
+// Paths that merge are only walked once, so this is linear in the number of distinct nodes.
+static std::set<uint64_t> CalcPaths(const std::set<uint64_t>& peaks, const std::vector<LeafIndex>& leaves)
+{
+    std::set<uint64_t> path;
+    for (const LeafIndex& leaf : leaves) {
+        Index node = leaf.GetNodeIndex();
+        while (path.insert(node.GetPosition()).second && peaks.count(node.GetPosition()) == 0) {
+            node = node.GetParent();
+        }
+    }
+
+    return path;
+}
+
+static std::set<uint64_t> GetPeakPositions(const uint64_t num_leaves)
+{
+    std::set<uint64_t> peaks;
+    for (const Index& peak : MMRUtil::CalcPeaks(LeafIndex::At(num_leaves).GetPosition())) {
+        peaks.insert(peak.GetPosition());
+    }
+
+    return peaks;
+}
+
+static std::vector<Index> CalcProofPositions(const std::set<uint64_t>& peaks, const std::set<uint64_t>& path)
+{
+    std::set<uint64_t> positions;
+    for (const uint64_t pos : path) {
+        if (peaks.count(pos) == 0) {
+            const uint64_t sibling = Index::At(pos).GetSibling().GetPosition();
+            if (path.count(sibling) == 0) {
+                positions.insert(sibling);
+            }
+        }
+    }
+
+    for (const uint64_t peak : peaks) {
+        if (path.count(peak) == 0) {
+            positions.insert(peak);
+        }
+    }
+
+    std::vector<Index> indices;
+    indices.reserve(positions.size());
+    for (const uint64_t pos : positions) {
+        indices.push_back(Index::At(pos));
+    }
+
+    return indices;
+}
+
+std::vector<Index> MMRProof::CalcProofPositions(const uint64_t num_leaves, const std::vector<LeafIndex>& leaves)
+{
+    const std::set<uint64_t> peaks = GetPeakPositions(num_leaves);
+    return ::CalcProofPositions(peaks, CalcPaths(peaks, leaves));
+}
+
+boost::optional<mw::Hash> MMRProof::CalcRoot(const std::vector<mw::Hash>& leaf_hashes) const
+{
+    // The leaf limit keeps the position arithmetic for an untrusted proof from overflowing.
+    if (m_numLeaves > (1ULL << 62) || m_leaves.empty() || leaf_hashes.size() != m_leaves.size() || m_leaves.back().Get() >= m_numLeaves) {
+        return boost::none;
+    }
+
+    for (size_t i = 1; i < m_leaves.size(); i++) {
+        if (m_leaves[i - 1] >= m_leaves[i]) {
+            return boost::none;
+        }
+    }
+
+    const std::set<uint64_t> peaks = GetPeakPositions(m_numLeaves);
+    const std::set<uint64_t> path = CalcPaths(peaks, m_leaves);
+    const std::vector<Index> positions = ::CalcProofPositions(peaks, path);
+    if (positions.size() != m_hashes.size()) {
+        return boost::none;
+    }
+
+    std::map<uint64_t, mw::Hash> hashes;
+    for (size_t i = 0; i < m_leaves.size(); i++) {
+        hashes[m_leaves[i].GetPosition()] = leaf_hashes[i];
+    }
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        hashes[positions[i].GetPosition()] = m_hashes[i];
+    }
+
+    // Parents always come after their children, so the path can be computed in order of position.
+    for (const uint64_t pos : path) {
+        const Index idx = Index::At(pos);
+        if (!idx.IsLeaf()) {
+            auto left_iter = hashes.find(idx.left_child_pos());
+            auto right_iter = hashes.find(idx.right_child_pos());
+            if (left_iter == hashes.end() || right_iter == hashes.end()) {
+                return boost::none;
+            }
+
+            hashes[pos] = MMRUtil::CalcParentHash(idx, left_iter->second, right_iter->second);
+        }
+    }
+
+    std::vector<mw::Hash> peak_hashes;
+    peak_hashes.reserve(peaks.size());
+    for (const uint64_t peak : peaks) {
+        peak_hashes.push_back(hashes.at(peak));
+    }
+
+    return MMRUtil::BagPeaks(LeafIndex::At(m_numLeaves).GetPosition(), peak_hashes);
+}
@@ -114,6 +114,41 @@ BitSet MMRUtil::CalcPrunedParents(const BitSet& unspent_leaf_indices)
     return ret;
 }
 
+std::vector<Index> MMRUtil::CalcPeaks(const uint64_t num_nodes)
+{
+    std::vector<Index> peaks;
+
+    uint64_t peakSize = BitUtil::FillOnesToRight(num_nodes);
+    uint64_t numLeft = num_nodes;
+    uint64_t sumPrevPeaks = 0;
+    while (peakSize != 0) {
+        if (numLeft >= peakSize) {
+            peaks.push_back(Index::At(sumPrevPeaks + peakSize - 1));
+            sumPrevPeaks += peakSize;
+            numLeft -= peakSize;
+        }
+
+        peakSize >>= 1;
+    }
+
+    assert(numLeft == 0);
+    return peaks;
+}
+
+mw::Hash MMRUtil::BagPeaks(const uint64_t num_nodes, const std::vector<mw::Hash>& peak_hashes)
+{
+    mw::Hash hash;
+    for (auto iter = peak_hashes.crbegin(); iter != peak_hashes.crend(); iter++) {
+        if (hash.IsZero()) {
+            hash = *iter;
+        } else {
+            hash = CalcParentHash(Index::At(num_nodes), *iter, hash);
+        }
+    }
+
+    return hash;
+}
+
 SiblingIter::SiblingIter(const uint64_t height, const Index& last_node)
     : m_height(height),
     m_lastNode(last_node),
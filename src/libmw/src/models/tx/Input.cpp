@@ -36,16 +36,18 @@ Input Input::Create(const mw::Hash& output_id, const Commitment& commitment, con
     );
 }
 
-SignedMessage Input::BuildSignedMsg() const noexcept
+mw::Hash Input::ComputeSignatureMessage() const noexcept
 {
-    // Calculate message hash
     Hasher msg_hasher;
     msg_hasher << m_features << GetOutputID();
     if (m_features & EXTRA_DATA_FEATURE_BIT) {
         msg_hasher << GetExtraData();
     }
-    mw::Hash message = msg_hasher.hash();
+    return msg_hasher.hash();
+}
 
+SignedMessage Input::BuildSignedMsg() const noexcept
+{
     // Calculate public key
     PublicKey public_key = GetOutputPubKey();
     if (m_features & STEALTH_KEY_FEATURE_BIT) {
@@ -60,5 +62,5 @@ SignedMessage Input::BuildSignedMsg() const noexcept
             .Add(*GetInputPubKey());
     }
 
-    return SignedMessage{message, public_key, GetSignature()};
+    return SignedMessage{m_sigMessage, public_key, GetSignature()};
 }
\ No newline at end of file
@@ -71,7 +71,12 @@ SignedMessage Kernel::BuildSignedMsg() const
             .Add(stealth_excess);
     }
 
-    mw::Hash sig_message = Kernel::GetSignatureMessage(
+    return SignedMessage{m_sigMessage, public_key, GetSignature()};
+}
+
+mw::Hash Kernel::ComputeSignatureMessage() const
+{
+    return Kernel::GetSignatureMessage(
         m_features,
         m_excess,
         m_stealthExcess,
@@ -81,7 +86,6 @@ SignedMessage Kernel::BuildSignedMsg() const
         m_lockHeight,
         m_extraData
     );
-    return SignedMessage{sig_message, public_key, GetSignature()};
 }
 
 mw::Hash Kernel::GetSignatureMessage(
@@ -90,14 +90,7 @@ Output Output::Create(
 
 SignedMessage Output::BuildSignedMsg() const noexcept
 {
-    mw::Hash hashed_msg = Hasher()
-        .Append(m_commitment)
-        .Append(m_senderPubKey)
-        .Append(m_receiverPubKey)
-        .Append(m_message.GetHash())
-        .Append(m_pProof->GetHash())
-        .hash();
-    return SignedMessage{ std::move(hashed_msg), m_senderPubKey, m_signature };
+    return SignedMessage{ m_sigMessage, m_senderPubKey, m_signature };
 }
 
 ProofData Output::BuildProofData() const noexcept
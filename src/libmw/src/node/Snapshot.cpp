@@ -0,0 +1,187 @@
+#include <mw/node/Snapshot.h>
+
+#include <mw/crypto/Hasher.h>
+#include <mw/db/LeafDB.h>
+#include <mw/db/MMRInfoDB.h>
+#include <mw/exceptions/DeserializationException.h>
+#include <mw/exceptions/ValidationException.h>
+#include <mw/file/File.h>
+#include <mw/mmr/LeafSet.h>
+#include <mw/mmr/MMRUtil.h>
+#include <mw/mmr/PruneList.h>
+
+using namespace mw;
+
+// Snapshots are always loaded into the first set of MMR files.
+static constexpr uint32_t SNAPSHOT_FILE_INDEX = 0;
+
+static uint64_t GetNumNodes(const uint64_t num_leaves)
+{
+    return mmr::LeafIndex::At(num_leaves).GetPosition();
+}
+
+// Replaces any existing file (eg. the empty ones created by CoinsViewDB::Open) with an empty one.
+static File CreateEmptyFile(const FilePath& path)
+{
+    File file(path);
+    file.Create();
+    file.Truncate(0);
+    return file;
+}
+
+SnapshotWriter::SnapshotWriter(const ICoinsView::Ptr& pView)
+    : m_pHeader(pView->GetBestHeader())
+{
+    assert(!pView->IsCache());
+
+    const uint64_t num_leaves = m_pHeader != nullptr ? m_pHeader->GetNumTXOs() : 0;
+    m_leafset = pView->GetLeafSet()->ToBitSet();
+    if (m_leafset.size() != num_leaves) {
+        ThrowDatabase_F("Leafset size {} does not match header {}", m_leafset.size(), num_leaves);
+    }
+
+    IMMR::Ptr pOutputPMMR = pView->GetOutputPMMR();
+    const BitSet compacted = MMRUtil::BuildCompactBitSet(num_leaves, m_leafset);
+    const uint64_t num_nodes = GetNumNodes(num_leaves);
+
+    m_hashes.reserve(num_nodes - compacted.count());
+    for (uint64_t pos = 0; pos < num_nodes; pos++) {
+        if (!compacted.test(pos)) {
+            m_hashes.push_back(pOutputPMMR->GetHash(mmr::Index::At(pos)));
+        }
+    }
+
+    m_pCursor = CoinDB(pView->GetDatabase().get()).GetCursor();
+}
+
+SnapshotLoader::SnapshotLoader(const FilePath& datadir, const mw::DBWrapper::Ptr& pDBWrapper, const mw::Header::CPtr& pHeader)
+    : m_datadir(datadir), m_pDatabase(pDBWrapper), m_pHeader(pHeader)
+{
+    assert(pHeader != nullptr);
+
+    if (MMRInfoDB(m_pDatabase.get()).GetLatest() != nullptr) {
+        ThrowDatabase("Can't load a snapshot over existing MWEB state");
+    }
+}
+
+uint64_t SnapshotLoader::LoadLeafSet(BitSet&& leafset)
+{
+    // The serialized bitset is padded to a multiple of 8 bits.
+    const uint64_t num_leaves = m_pHeader->GetNumTXOs();
+    if (leafset.size() < num_leaves || leafset.size() >= num_leaves + 8) {
+        ThrowDeserialization_F("Leafset has {} bits, but header has {} TXOs", leafset.size(), num_leaves);
+    }
+
+    for (uint64_t i = num_leaves; i < leafset.size(); i++) {
+        if (leafset.test(i)) {
+            ThrowValidation(EConsensusError::MMR_MISMATCH);
+        }
+    }
+
+    leafset.bitset.resize(num_leaves);
+    if (Hashed(leafset.bytes()) != m_pHeader->GetLeafsetRoot()) {
+        ThrowValidation(EConsensusError::MMR_MISMATCH);
+    }
+
+    m_leafset = std::move(leafset);
+    m_loaded = BitSet(num_leaves);
+
+    const BitSet compacted = MMRUtil::BuildCompactBitSet(num_leaves, m_leafset);
+    CreateEmptyFile(PruneList::GetPath(m_datadir, SNAPSHOT_FILE_INDEX));
+    PruneList::Open(m_datadir, SNAPSHOT_FILE_INDEX)->Commit(SNAPSHOT_FILE_INDEX, compacted);
+
+    CreateEmptyFile(PMMR::GetPath(m_datadir, 'O', SNAPSHOT_FILE_INDEX));
+
+    return GetNumNodes(num_leaves) - compacted.count();
+}
+
+void SnapshotLoader::AddHashes(const std::vector<mw::Hash>& hashes)
+{
+    std::vector<uint8_t> bytes;
+    bytes.reserve(hashes.size() * mw::Hash::size());
+    for (const mw::Hash& hash : hashes) {
+        bytes.insert(bytes.end(), hash.data(), hash.data() + mw::Hash::size());
+    }
+
+    File(PMMR::GetPath(m_datadir, 'O', SNAPSHOT_FILE_INDEX)).Write(bytes);
+}
+
+void SnapshotLoader::OpenOutputPMMR()
+{
+    auto pPruneList = PruneList::Open(m_datadir, SNAPSHOT_FILE_INDEX);
+    m_pOutputPMMR = PMMR::Open('O', m_datadir, SNAPSHOT_FILE_INDEX, m_pDatabase, pPruneList);
+
+    if (m_pOutputPMMR->GetNumLeaves() != m_pHeader->GetNumTXOs()
+        || m_pOutputPMMR->Root() != m_pHeader->GetOutputRoot()) {
+        ThrowValidation(EConsensusError::MMR_MISMATCH);
+    }
+}
+
+void SnapshotLoader::AddUTXO(const UTXO::CPtr& pUTXO)
+{
+    // Each UTXO must be committed to by an unspent leaf of the (already verified) output PMMR.
+    const mmr::LeafIndex& leaf_idx = pUTXO->GetLeafIndex();
+    if (!m_leafset.test(leaf_idx.Get()) || m_loaded.test(leaf_idx.Get())) {
+        ThrowValidation(EConsensusError::UTXO_MISSING);
+    }
+
+    mmr::Leaf leaf = mmr::Leaf::Create(leaf_idx, pUTXO->GetOutputID().vec());
+    if (leaf.GetHash() != m_pOutputPMMR->GetHash(leaf_idx.GetNodeIndex())) {
+        ThrowValidation(EConsensusError::MMR_MISMATCH);
+    }
+
+    m_loaded.set(leaf_idx.Get());
+    m_utxos.push_back(pUTXO);
+
+    if (m_utxos.size() >= UTXO_BATCH_SIZE) {
+        WriteUTXOs();
+    }
+}
+
+void SnapshotLoader::WriteUTXOs()
+{
+    if (m_utxos.empty()) {
+        return;
+    }
+
+    std::vector<mmr::Leaf> leaves;
+    leaves.reserve(m_utxos.size());
+    for (const UTXO::CPtr& pUTXO : m_utxos) {
+        leaves.push_back(mmr::Leaf::Create(pUTXO->GetLeafIndex(), pUTXO->GetOutputID().vec()));
+    }
+
+    auto pBatch = m_pDatabase->CreateBatch();
+    CoinDB(m_pDatabase.get(), pBatch.get()).AddUTXOs(m_utxos);
+    LeafDB('O', m_pDatabase.get(), pBatch.get()).Add(leaves);
+    pBatch->Commit();
+
+    m_utxos.clear();
+}
+
+CoinsViewDB::Ptr SnapshotLoader::Finish()
+{
+    WriteUTXOs();
+
+    if (m_loaded.count() != m_leafset.count()) {
+        ThrowValidation(EConsensusError::UTXO_MISSING);
+    }
+
+    File leafset_file = CreateEmptyFile(LeafSet::GetPath(m_datadir, SNAPSHOT_FILE_INDEX));
+    std::vector<uint8_t> leafset_bytes = mmr::LeafIndex::At(m_leafset.size()).Serialized();
+    const std::vector<uint8_t> bitmap = m_leafset.bytes();
+    leafset_bytes.insert(leafset_bytes.end(), bitmap.cbegin(), bitmap.cend());
+    leafset_file.Write(leafset_bytes);
+
+    // The MMR can't be rewound beyond the snapshot, since the compacted nodes are gone.
+    auto pBatch = m_pDatabase->CreateBatch();
+    MMRInfoDB(m_pDatabase.get(), pBatch.get()).Save(MMRInfo{
+        0,
+        SNAPSHOT_FILE_INDEX,
+        m_pHeader->GetHash(),
+        SNAPSHOT_FILE_INDEX,
+        m_pHeader->GetHash()
+    });
+    pBatch->Commit();
+
+    return CoinsViewDB::Open(m_datadir, m_pHeader, m_pDatabase);
+}
@@ -94,4 +94,79 @@ BOOST_AUTO_TEST_CASE(PMMRCacheTest)
     cache.Flush(1, nullptr);
 }
 
+BOOST_AUTO_TEST_CASE(MMRProofTest)
+{
+    MemMMR mmr;
+    std::vector<mw::Hash> leaf_hashes;
+    for (uint8_t i = 0; i < 11; i++) {
+        mmr::LeafIndex idx = mmr.Add(std::vector<uint8_t>{ i, (uint8_t)(i + 1), (uint8_t)(i + 2) });
+        leaf_hashes.push_back(mmr.GetLeaf(idx).GetHash());
+    }
+
+    const mw::Hash root = mmr.Root();
+
+    // Every leaf can be proven individually
+    std::vector<size_t> individual_sizes;
+    for (uint64_t i = 0; i < 11; i++) {
+        MMRProof proof = mmr.BuildProof({ LeafIndex::At(i) });
+        BOOST_REQUIRE(proof.GetNumLeaves() == 11);
+        BOOST_REQUIRE(proof.Verify(root, { leaf_hashes[i] }));
+        BOOST_REQUIRE(!proof.Verify(root, { leaf_hashes[(i + 1) % 11] }));
+        individual_sizes.push_back(proof.GetHashes().size());
+    }
+
+    // Batched proofs share sibling hashes, and need no hashes for siblings that are being proven
+    MMRProof batch = mmr.BuildProof({ LeafIndex::At(9), LeafIndex::At(0), LeafIndex::At(1), LeafIndex::At(4), LeafIndex::At(1) });
+    BOOST_REQUIRE(batch.GetLeaves() == std::vector<LeafIndex>({ LeafIndex::At(0), LeafIndex::At(1), LeafIndex::At(4), LeafIndex::At(9) }));
+    BOOST_REQUIRE(batch.Verify(root, { leaf_hashes[0], leaf_hashes[1], leaf_hashes[4], leaf_hashes[9] }));
+    BOOST_REQUIRE(batch.GetHashes().size() == 5);
+    BOOST_REQUIRE(batch.GetHashes().size() < individual_sizes[0] + individual_sizes[1] + individual_sizes[4] + individual_sizes[9]);
+
+    MMRProof all;
+    {
+        std::vector<LeafIndex> leaves;
+        for (uint64_t i = 0; i < 11; i++) {
+            leaves.push_back(LeafIndex::At(i));
+        }
+        all = mmr.BuildProof(leaves);
+    }
+    BOOST_REQUIRE(all.GetHashes().empty());
+    BOOST_REQUIRE(all.Verify(root, leaf_hashes));
+
+    // Serialization
+    {
+        std::vector<uint8_t> serialized = batch.Serialized();
+        MMRProof batch2;
+        CDataStream(serialized, SER_DISK, PROTOCOL_VERSION) >> batch2;
+        BOOST_REQUIRE(batch2.GetNumLeaves() == batch.GetNumLeaves());
+        BOOST_REQUIRE(batch2.GetLeaves() == batch.GetLeaves());
+        BOOST_REQUIRE(batch2.GetHashes() == batch.GetHashes());
+        BOOST_REQUIRE(batch2.Verify(root, { leaf_hashes[0], leaf_hashes[1], leaf_hashes[4], leaf_hashes[9] }));
+    }
+
+    // Tampered proofs
+    {
+        std::vector<mw::Hash> hashes = batch.GetHashes();
+        hashes.front() = mw::Hash();
+        MMRProof tampered(batch.GetNumLeaves(), batch.GetLeaves(), hashes);
+        BOOST_REQUIRE(!tampered.Verify(root, { leaf_hashes[0], leaf_hashes[1], leaf_hashes[4], leaf_hashes[9] }));
+
+        hashes = batch.GetHashes();
+        hashes.pop_back();
+        MMRProof missing_hash(batch.GetNumLeaves(), batch.GetLeaves(), hashes);
+        BOOST_REQUIRE(!missing_hash.CalcRoot({ leaf_hashes[0], leaf_hashes[1], leaf_hashes[4], leaf_hashes[9] }));
+
+        MMRProof wrong_size(10, batch.GetLeaves(), batch.GetHashes());
+        BOOST_REQUIRE(!wrong_size.Verify(root, { leaf_hashes[0], leaf_hashes[1], leaf_hashes[4], leaf_hashes[9] }));
+
+        MMRProof unsorted(11, { LeafIndex::At(1), LeafIndex::At(0) }, {});
+        BOOST_REQUIRE(!unsorted.CalcRoot({ leaf_hashes[1], leaf_hashes[0] }));
+
+        MMRProof out_of_range(11, { LeafIndex::At(11) }, {});
+        BOOST_REQUIRE(!out_of_range.CalcRoot({ leaf_hashes[0] }));
+    }
+
+    BOOST_CHECK_THROW(mmr.BuildProof({ LeafIndex::At(11) }), std::exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -50,6 +50,7 @@ BOOST_AUTO_TEST_CASE(PlainTxInput)
         BOOST_REQUIRE(signature2 == signature);
 
         BOOST_REQUIRE(input == Input::Deserialize(serialized));
+        BOOST_REQUIRE(input.BuildSignedMsg() == Input::Deserialize(serialized).BuildSignedMsg());
     }
 
     //
@@ -24,6 +24,7 @@ BOOST_AUTO_TEST_CASE(PlainKernel_Test)
         Kernel kernel2;
         CDataStream(serialized, SER_DISK, 0) >> kernel2;
         BOOST_REQUIRE(kernel == kernel2);
+        BOOST_REQUIRE(kernel.BuildSignedMsg() == kernel2.BuildSignedMsg());
     }
 
     //
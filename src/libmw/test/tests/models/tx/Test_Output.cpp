@@ -54,6 +54,7 @@ BOOST_AUTO_TEST_CASE(Create)
     SignedMessage signed_msg = output.BuildSignedMsg();
     BOOST_REQUIRE(signed_msg.GetPublicKey() == PublicKey::From(sender_key));
     BOOST_REQUIRE(Schnorr::BatchVerify({ signed_msg }));
+    BOOST_REQUIRE(Output::Deserialize(output.Serialized()).BuildSignedMsg() == signed_msg);
 
     // Verify Output ID
     mw::Hash expected_id = Hasher()
@@ -0,0 +1,123 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <mw/node/CoinsView.h>
+#include <mw/node/Snapshot.h>
+#include <mw/exceptions/ValidationException.h>
+
+#include <test_framework/Miner.h>
+#include <test_framework/TestMWEB.h>
+
+BOOST_FIXTURE_TEST_SUITE(TestSnapshot, MWEBTestingSetup)
+
+BOOST_AUTO_TEST_CASE(SnapshotRoundTrip)
+{
+    auto pDatabase = GetDB();
+
+    auto pDBView = mw::CoinsViewDB::Open(GetDataDir(), nullptr, pDatabase);
+    auto pCachedView = std::make_shared<mw::CoinsViewCache>(pDBView);
+
+    test::Miner miner(GetDataDir());
+
+    ///////////////////////
+    // Mine Block 1
+    ///////////////////////
+    std::vector<test::Tx> block1_txs{
+        test::Tx::CreatePegIn(1000),
+        test::Tx::CreatePegIn(2000),
+        test::Tx::CreatePegIn(3000),
+        test::Tx::CreatePegIn(4000)
+    };
+    auto block1 = miner.MineBlock(150, block1_txs);
+    pCachedView->ApplyBlock(block1.GetBlock());
+
+    ///////////////////////
+    // Mine Block 2 - Spends the first 2 leaves, so they can be compacted.
+    ///////////////////////
+    std::vector<mw::Hash> spent_ids;
+    std::vector<test::Tx> block2_txs{ test::Tx::CreatePegIn(5000) };
+    for (const Output& output : block1.GetBlock()->GetOutputs()) {
+        UTXO::CPtr pUTXO = pCachedView->GetUTXO(output.GetOutputID());
+        if (pUTXO->GetLeafIndex().Get() < 2) {
+            auto iter = std::find_if(
+                block1_txs.cbegin(), block1_txs.cend(),
+                [&output](const test::Tx& tx) { return tx.GetOutputs().front().GetOutputID() == output.GetOutputID(); }
+            );
+            block2_txs.push_back(test::Tx::CreatePegOut(iter->GetOutputs().front()));
+            spent_ids.push_back(output.GetOutputID());
+        }
+    }
+    BOOST_REQUIRE(spent_ids.size() == 2);
+
+    auto block2 = miner.MineBlock(151, block2_txs);
+    pCachedView->ApplyBlock(block2.GetBlock());
+
+    auto pBatch = pDatabase->CreateBatch();
+    pCachedView->Flush(pBatch);
+    pBatch->Commit();
+
+    ///////////////////////
+    // Write Snapshot
+    ///////////////////////
+    CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+    mw::SnapshotWriter writer(pDBView);
+    BOOST_REQUIRE(*writer.GetHeader() == *block2.GetBlock()->GetHeader());
+    BOOST_REQUIRE(writer.GetNumUTXOs() == 3);
+    writer.Write(stream);
+
+    // Leaves 0 & 1 are compacted, so only 6 of the 8 output PMMR hashes are written.
+    size_t expected_size = ::GetSerializeSize(pDBView->GetLeafSet()->ToBitSet(), PROTOCOL_VERSION) + (6 * mw::Hash::size());
+    for (const Output& output : block1.GetBlock()->GetOutputs()) {
+        UTXO::CPtr pUTXO = pDBView->GetUTXO(output.GetOutputID());
+        if (pUTXO != nullptr) {
+            expected_size += ::GetSerializeSize(*pUTXO, PROTOCOL_VERSION);
+        }
+    }
+    expected_size += ::GetSerializeSize(*pDBView->GetUTXO(block2_txs.front().GetOutputs().front().GetOutputID()), PROTOCOL_VERSION);
+    BOOST_REQUIRE(stream.size() == expected_size);
+
+    ///////////////////////
+    // Load Snapshot
+    ///////////////////////
+    CDBWrapper snapshot_db(GetDataDir() / "snapshot_db", 1 << 15);
+    auto pSnapshotDatabase = std::make_shared<MWEB::DBWrapper>(&snapshot_db);
+    FilePath snapshot_dir = GetDataDir() / "snapshot";
+
+    {
+        // Loading against the wrong header must fail.
+        CDataStream bad_stream = stream;
+        mw::SnapshotLoader loader(snapshot_dir, pSnapshotDatabase, block1.GetBlock()->GetHeader());
+        BOOST_CHECK_THROW(loader.Load(bad_stream), ValidationException);
+    }
+
+    mw::SnapshotLoader loader(snapshot_dir, pSnapshotDatabase, block2.GetBlock()->GetHeader());
+    auto pLoadedView = loader.Load(stream);
+    BOOST_REQUIRE(stream.empty());
+
+    BOOST_REQUIRE(pLoadedView->GetOutputPMMR()->Root() == block2.GetBlock()->GetHeader()->GetOutputRoot());
+    BOOST_REQUIRE(pLoadedView->GetLeafSet()->Root() == block2.GetBlock()->GetHeader()->GetLeafsetRoot());
+    for (const Output& output : block1.GetBlock()->GetOutputs()) {
+        const bool spent = std::find(spent_ids.cbegin(), spent_ids.cend(), output.GetOutputID()) != spent_ids.cend();
+        BOOST_REQUIRE(pLoadedView->HasCoin(output.GetOutputID()) == !spent);
+    }
+    BOOST_REQUIRE(pLoadedView->HasCoin(block2_txs.front().GetOutputs().front().GetOutputID()));
+
+    ///////////////////////
+    // Mine Block 3 on top of the loaded snapshot
+    ///////////////////////
+    test::Tx block3_tx1 = test::Tx::CreatePegIn(6000);
+    auto block3 = miner.MineBlock(152, { block3_tx1 });
+
+    auto pLoadedCache = std::make_shared<mw::CoinsViewCache>(pLoadedView);
+    pLoadedCache->ApplyBlock(block3.GetBlock());
+
+    auto pSnapshotBatch = pSnapshotDatabase->CreateBatch();
+    pLoadedCache->Flush(pSnapshotBatch);
+    pSnapshotBatch->Commit();
+
+    BOOST_REQUIRE(pLoadedView->HasCoin(block3_tx1.GetOutputs().front().GetOutputID()));
+    BOOST_REQUIRE(pLoadedView->GetOutputPMMR()->Root() == block3.GetBlock()->GetHeader()->GetOutputRoot());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
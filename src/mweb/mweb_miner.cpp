@@ -102,7 +102,7 @@ template <>
 struct hash<PegInCoin> {
     size_t operator()(const PegInCoin& pegin) const
     {
-        return boost::hash_value(pegin.GetKernelID().vec()) + boost::hash_value(pegin.GetAmount());
+        return boost::hash_range(pegin.GetKernelID().data(), pegin.GetKernelID().data() + pegin.GetKernelID().size()) + boost::hash_value(pegin.GetAmount());
     }
 };
 } // namespace std
@@ -2,16 +2,74 @@
 
 #include <chain.h>
 #include <consensus/validation.h>
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
 #include <mw/node/BlockValidator.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <random.h>
 #include <script/interpreter.h>
+#include <script/sigcache.h>
+#include <sync.h>
 #include <undo.h>
 #include <util/system.h>
 #include <validation.h>
 
 using namespace MWEB;
 
+/** Memory used by the cache of valid MWEB transactions */
+static const size_t MWEB_TX_CACHE_BYTES = 1 << 20;
+
+namespace {
+/**
+ * Salted hashes of the MWEB transactions that passed validation. A
+ * transaction's hash commits to all of its proofs and signatures, so one
+ * verified by the message handler before it takes cs_main doesn't have to be
+ * verified again by AcceptToMemoryPool.
+ */
+class ValidTxCache
+{
+public:
+    ValidTxCache()
+    {
+        const uint256 nonce = GetRandHash();
+        m_salted_hasher.Write(nonce.begin(), 32);
+        m_salted_hasher.Write(nonce.begin(), 32);
+        m_cache.setup_bytes(MWEB_TX_CACHE_BYTES);
+    }
+
+    uint256 GetEntry(const mw::Hash& tx_hash) const
+    {
+        uint256 entry;
+        CSHA256(m_salted_hasher).Write(tx_hash.data(), tx_hash.size()).Finalize(entry.begin());
+        return entry;
+    }
+
+    bool Contains(const uint256& entry)
+    {
+        LOCK(m_mutex);
+        return m_cache.contains(entry, /* erase */ false);
+    }
+
+    void Insert(const uint256& entry)
+    {
+        LOCK(m_mutex);
+        m_cache.insert(entry);
+    }
+
+private:
+    CSHA256 m_salted_hasher;
+    Mutex m_mutex;
+    CuckooCache::cache<uint256, SignatureCacheHasher> m_cache GUARDED_BY(m_mutex);
+};
+
+ValidTxCache& GetValidTxCache()
+{
+    static ValidTxCache cache;
+    return cache;
+}
+} // namespace
+
 bool Node::CheckBlock(const CBlock& block, BlockValidationState& state)
 {
     // HasMWEBTx() is true only when mweb txs being shared outside of a block (for use by mempools).
@@ -250,12 +308,58 @@ bool Node::CheckTransaction(const CTransaction& tx, TxValidationState& state)
 
     // If the transaction has MWEB data, call the libmw transaction validation logic.
     if (tx.HasMWEBTx()) {
+        ValidTxCache& cache = GetValidTxCache();
+        const uint256 entry = cache.GetEntry(tx.mweb_tx.m_transaction->GetHash());
+        if (cache.Contains(entry)) {
+            return true;
+        }
+
         try {
             tx.mweb_tx.m_transaction->Validate();
         } catch (const std::exception& e) {
             return state.Invalid(TxValidationResult::TX_WITNESS_MUTATED, "bad-mweb-txn");
         }
+        cache.Insert(entry);
+    }
+
+    return true;
+}
+bool Node::BuildUTXOProof(CChainState& chainstate, const std::vector<mw::Hash>& output_ids, UTXOProof& proof, std::string& error)
+{
+    AssertLockHeld(cs_main);
+
+    const CBlockIndex* pindex = chainstate.m_chain.Tip();
+    if (pindex == nullptr || GetMWEBHeader(pindex) == nullptr) {
+        error = "MWEB is not active";
+        return false;
+    }
+
+    mw::CoinsViewCache::Ptr mweb_view = chainstate.CoinsTip().GetMWEBCacheView();
+
+    std::map<mmr::LeafIndex, mw::Hash> output_ids_by_leaf;
+    for (const mw::Hash& output_id : output_ids) {
+        UTXO::CPtr utxo = mweb_view->GetUTXO(output_id);
+        if (utxo == nullptr) {
+            error = "Output not found in UTXO set: " + output_id.ToHex();
+            return false;
+        }
+
+        output_ids_by_leaf[utxo->GetLeafIndex()] = output_id;
+    }
+
+    std::vector<mmr::LeafIndex> leaves;
+    proof.output_ids.clear();
+    for (const auto& leaf : output_ids_by_leaf) {
+        leaves.push_back(leaf.first);
+        proof.output_ids.push_back(leaf.second);
     }
 
+    proof.block_hash = pindex->GetBlockHash();
+    proof.proof = mweb_view->GetOutputPMMR()->BuildProof(std::move(leaves));
     return true;
-}
\ No newline at end of file
+}
+
+size_t Node::MaxUTXOProofOutputs()
+{
+    return std::max<int64_t>(gArgs.GetArg("-maxmwebutxoproofoutputs", DEFAULT_MAX_UTXO_PROOF_OUTPUTS), 1);
+}
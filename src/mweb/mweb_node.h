@@ -2,11 +2,13 @@
 
 #include <consensus/params.h>
 #include <mw/node/CoinsView.h>
+#include <mweb/mweb_proof.h>
 
 // Forward Declarations
 class CBlock;
 class CBlockUndo;
 class CBlockIndex;
+class CChainState;
 class CTransaction;
 class BlockValidationState;
 class TxValidationState;
@@ -101,6 +103,29 @@ public:
     /// <returns>True if all validation checks succeed.</returns>
     static bool CheckTransaction(const CTransaction& tx, TxValidationState& state);
 
+    /// <summary>
+    /// Builds a proof that the given outputs are included in the output MMR of the chainstate's tip.
+    /// The outputs must be unspent, since their leaf indices are looked up in the UTXO set.
+    /// Requires cs_main.
+    /// </summary>
+    /// <param name="chainstate">The chainstate whose tip the proof should commit to.</param>
+    /// <param name="output_ids">The IDs of the outputs to prove.</param>
+    /// <param name="proof">The UTXOProof to populate.</param>
+    /// <param name="error">Set to the reason the proof couldn't be built when this fails.</param>
+    /// <returns>True if the proof was built.</returns>
+    static bool BuildUTXOProof(
+        CChainState& chainstate,
+        const std::vector<mw::Hash>& output_ids,
+        UTXOProof& proof,
+        std::string& error
+    );
+
+    /// <summary>
+    /// The most outputs that one UTXOProof may be requested for over RPC or REST,
+    /// as set by -maxmwebutxoproofoutputs.
+    /// </summary>
+    static size_t MaxUTXOProofOutputs();
+
 private:
     static bool ValidateMWEBBlock(const CBlock& block);
 };
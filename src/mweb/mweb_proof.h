@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mw/mmr/Leaf.h>
+#include <mw/mmr/MMRProof.h>
+#include <mw/models/block/Header.h>
+#include <serialize.h>
+#include <uint256.h>
+
+namespace MWEB {
+
+//! Default for -maxmwebutxoproofoutputs, the most outputs that a single UTXOProof may be
+//! requested for over RPC or REST. Proofs are built while holding cs_main, with a UTXO lookup
+//! and up to one MMR path per output, so this bounds how long one request can hold it.
+//! 256 is above the roughly 120 output IDs that fit in a REST URI, so by default only
+//! RPC callers, which must be authenticated, can reach it.
+static constexpr int64_t DEFAULT_MAX_UTXO_PROOF_OUTPUTS = 256;
+
+/**
+ * Proves that MWEB outputs are included in the output MMR committed to by the
+ * MWEB header of a block. This proves the outputs exist at their leaf indices,
+ * not that they're still unspent.
+ */
+struct UTXOProof
+{
+    //! The hash of the block whose MWEB header the proof commits to.
+    uint256 block_hash;
+
+    //! The IDs of the outputs being proven, in the same order as the proof's leaves.
+    std::vector<mw::Hash> output_ids;
+
+    MMRProof proof;
+
+    SERIALIZE_METHODS(UTXOProof, obj) { READWRITE(obj.block_hash, obj.output_ids, obj.proof); }
+
+    //! Checks the proof against the output root and size of the block's MWEB header.
+    bool Verify(const mw::Header& header) const
+    {
+        if (output_ids.size() != proof.GetLeaves().size() || proof.GetNumLeaves() != header.GetNumTXOs()) {
+            return false;
+        }
+
+        std::vector<mw::Hash> leaf_hashes;
+        leaf_hashes.reserve(output_ids.size());
+        for (size_t i = 0; i < output_ids.size(); i++) {
+            leaf_hashes.push_back(mmr::Leaf::CalcHash(proof.GetLeaves()[i], output_ids[i].vec()));
+        }
+
+        return proof.Verify(header.GetOutputRoot(), leaf_hashes);
+    }
+};
+
+} // namespace MWEB
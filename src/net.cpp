@@ -36,6 +36,10 @@
 #include <poll.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/upnpcommands.h>
@@ -46,6 +50,7 @@ static_assert(MINIUPNPC_API_VERSION >= 10, "miniUPnPc API version >= 10 assumed"
 #endif
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <unordered_map>
 
@@ -105,6 +110,18 @@ enum BindFlags {
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
+#ifdef USE_EPOLL
+// Further events are returned by the next call to epoll_wait()
+static const int MAX_EPOLL_EVENTS = 1024;
+#endif
+
+// Receive buffers for messages up to this size grow as their payload arrives
+static const unsigned int RECV_BUFFER_STEP = 256 * 1024;
+// Memory that may be set aside for the payloads of larger messages before they arrive
+static const size_t MAX_RECV_PRESIZE_BYTES = 16 * MAX_PROTOCOL_MESSAGE_LENGTH;
+// Memory held in buffers of processed messages, for reuse by later ones
+static const size_t MAX_POOLED_RECV_BYTES = 4 * MAX_PROTOCOL_MESSAGE_LENGTH;
+
 const std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
@@ -691,6 +708,104 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
     return true;
 }
 
+namespace {
+/**
+ * Buffers for large received messages. A buffer is sized for the whole payload
+ * as soon as the message header arrives, so it isn't reallocated and copied as
+ * the payload trickles in, and is kept once the message has been processed so
+ * the next large message doesn't have to allocate (and clear) one again.
+ */
+class RecvBufferPool
+{
+    Mutex m_mutex;
+    std::vector<CSerializeData> m_free GUARDED_BY(m_mutex);
+    size_t m_free_bytes GUARDED_BY(m_mutex){0};
+    size_t m_presized_bytes GUARDED_BY(m_mutex){0};
+
+public:
+    //! Size a buffer for an incoming payload, unless too much memory is already set aside for others
+    bool Acquire(CDataStream& stream, size_t size)
+    {
+        CSerializeData buffer;
+        {
+            LOCK(m_mutex);
+            if (m_presized_bytes + size > MAX_RECV_PRESIZE_BYTES) return false;
+            m_presized_bytes += size;
+
+            // Take the smallest free buffer that fits
+            auto best = m_free.end();
+            for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+                if (it->capacity() >= size && (best == m_free.end() || it->capacity() < best->capacity())) best = it;
+            }
+            if (best != m_free.end()) {
+                m_free_bytes -= best->capacity();
+                buffer.swap(*best);
+                m_free.erase(best);
+            }
+        }
+        stream.swap(buffer);
+        stream.resize(size);
+        return true;
+    }
+
+    //! Stop counting a payload passed to Acquire against the limit
+    void Release(size_t size)
+    {
+        LOCK(m_mutex);
+        assert(m_presized_bytes >= size);
+        m_presized_bytes -= size;
+    }
+
+    //! Keep the buffer of a processed message for reuse
+    void Recycle(CDataStream& stream)
+    {
+        CSerializeData buffer;
+        stream.swap(buffer);
+        if (buffer.capacity() <= RECV_BUFFER_STEP) return;
+        buffer.clear();
+
+        LOCK(m_mutex);
+        if (m_free_bytes + buffer.capacity() > MAX_POOLED_RECV_BYTES) return;
+        m_free_bytes += buffer.capacity();
+        m_free.push_back(std::move(buffer));
+    }
+};
+
+RecvBufferPool& GetRecvBufferPool()
+{
+    // Never destroyed, as messages may outlive other static objects
+    static RecvBufferPool& pool = *new RecvBufferPool();
+    return pool;
+}
+} // namespace
+
+CNetMessage::~CNetMessage()
+{
+    GetRecvBufferPool().Recycle(m_recv);
+}
+
+V1TransportDeserializer::~V1TransportDeserializer()
+{
+    if (m_presized_bytes > 0) GetRecvBufferPool().Release(m_presized_bytes);
+}
+
+void V1TransportDeserializer::Reset()
+{
+    if (m_presized_bytes > 0) {
+        GetRecvBufferPool().Release(m_presized_bytes);
+        GetRecvBufferPool().Recycle(vRecv);
+        m_presized_bytes = 0;
+    }
+    vRecv.clear();
+    hdrbuf.clear();
+    hdrbuf.resize(24);
+    in_data = false;
+    nHdrPos = 0;
+    nDataPos = 0;
+    data_hash.SetNull();
+    hasher.Reset();
+}
+
 int V1TransportDeserializer::readHeader(const char *pch, unsigned int nBytes)
 {
     // copy data to temporary parsing buffer
@@ -728,6 +843,10 @@ int V1TransportDeserializer::readHeader(const char *pch, unsigned int nBytes)
     // switch state to reading message data
     in_data = true;
 
+    if (hdr.nMessageSize > RECV_BUFFER_STEP && GetRecvBufferPool().Acquire(vRecv, hdr.nMessageSize)) {
+        m_presized_bytes = hdr.nMessageSize;
+    }
+
     return nCopy;
 }
 
@@ -738,7 +857,7 @@ int V1TransportDeserializer::readData(const char *pch, unsigned int nBytes)
 
     if (vRecv.size() < nDataPos + nCopy) {
         // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + RECV_BUFFER_STEP));
     }
 
     hasher.Write({(const unsigned char*)pch, nCopy});
@@ -1152,6 +1271,9 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
 
     LogPrint(BCLog::NET, "connection from %s accepted\n", addr.ToString());
 
+#ifdef USE_EPOLL
+    RegisterSocketEvents(pnode);
+#endif
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
@@ -1349,7 +1471,138 @@ bool CConnman::GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &s
     return !recv_set.empty() || !send_set.empty() || !error_set.empty();
 }
 
-#ifdef USE_POLL
+#ifdef USE_EPOLL
+bool CConnman::InitSocketEvents()
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd == -1) {
+        LogPrintf("epoll_create1 failed: %s\n", NetworkErrorString(errno));
+        return false;
+    }
+    if (pipe2(m_wakeup_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        LogPrintf("pipe2 failed: %s\n", NetworkErrorString(errno));
+        return false;
+    }
+
+    struct epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = m_wakeup_pipe;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_pipe[0], &event) != 0) {
+        LogPrintf("epoll_ctl failed for wakeup pipe: %s\n", NetworkErrorString(errno));
+        return false;
+    }
+
+    // Listening sockets are level-triggered, as AcceptConnection() only
+    // accepts one connection at a time.
+    for (ListenSocket& hListenSocket : vhListenSocket) {
+        event.data.ptr = &hListenSocket;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, hListenSocket.socket, &event) != 0) {
+            LogPrintf("epoll_ctl failed for listening socket: %s\n", NetworkErrorString(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+void CConnman::RegisterSocketEvents(CNode* pnode)
+{
+    if (m_epoll_fd == -1) return;
+
+    // The registration is removed when the socket is closed.
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = pnode;
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET) return;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+        LogPrintf("epoll_ctl failed for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(errno));
+        pnode->CloseSocketDisconnect();
+    }
+}
+
+void CConnman::GenerateReadySet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set)
+{
+    // Same logic as GenerateSelectSet(), for the nodes whose sockets are ready:
+    // drain the write buffer before receiving more, and don't receive while paused.
+    for (CNode* pnode : m_nodes_send_ready) {
+        {
+            LOCK(pnode->cs_vSend);
+            if (pnode->vSendMsg.empty()) continue;
+        }
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket != INVALID_SOCKET) {
+            send_set.insert(pnode->hSocket);
+        }
+    }
+
+    for (CNode* pnode : m_nodes_recv_ready) {
+        if (pnode->fPauseRecv) continue;
+        {
+            LOCK(pnode->cs_vSend);
+            if (!pnode->vSendMsg.empty()) continue;
+        }
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket != INVALID_SOCKET) {
+            recv_set.insert(pnode->hSocket);
+        }
+    }
+}
+
+void CConnman::SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set)
+{
+    // Only wait for new events when there's nothing left to do for sockets
+    // that were ready before.
+    GenerateReadySet(recv_set, send_set);
+    const int timeout = recv_set.empty() && send_set.empty() ? SELECT_TIMEOUT_MILLISECONDS : 0;
+    recv_set.clear();
+    send_set.clear();
+
+    std::array<struct epoll_event, MAX_EPOLL_EVENTS> events;
+    int nEvents = epoll_wait(m_epoll_fd, events.data(), events.size(), timeout);
+
+    if (interruptNet) return;
+
+    if (nEvents < 0) {
+        if (errno != EINTR) {
+            LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(errno));
+        }
+        nEvents = 0;
+    }
+
+    for (int i = 0; i < nEvents; ++i) {
+        const struct epoll_event& event = events[i];
+        if (event.data.ptr == m_wakeup_pipe) {
+            m_wakeup_pending = false;
+            char buf[64];
+            while (read(m_wakeup_pipe[0], buf, sizeof(buf)) > 0) {}
+            continue;
+        }
+
+        const auto listen_it = std::find_if(vhListenSocket.begin(), vhListenSocket.end(),
+            [&](const ListenSocket& hListenSocket) { return &hListenSocket == event.data.ptr; });
+        if (listen_it != vhListenSocket.end()) {
+            recv_set.insert(listen_it->socket);
+            continue;
+        }
+
+        CNode* pnode = static_cast<CNode*>(event.data.ptr);
+        if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            m_nodes_recv_ready.insert(pnode);
+        }
+        if (event.events & EPOLLOUT) {
+            m_nodes_send_ready.insert(pnode);
+        }
+        if (event.events & (EPOLLHUP | EPOLLERR)) {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket != INVALID_SOCKET) {
+                error_set.insert(pnode->hSocket);
+            }
+        }
+    }
+
+    GenerateReadySet(recv_set, send_set);
+}
+#elif defined(USE_POLL)
 void CConnman::SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set)
 {
     std::set<SOCKET> recv_select_set, send_select_set, error_select_set;
@@ -1545,7 +1798,7 @@ void CConnman::SocketHandler()
                         pnode->nProcessQueueSize += nSizeAdded;
                         pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
                     }
-                    WakeMessageHandler();
+                    WakeMessageHandler(*pnode);
                 }
             }
             else if (nBytes == 0)
@@ -1560,6 +1813,14 @@ void CConnman::SocketHandler()
             {
                 // error
                 int nErr = WSAGetLastError();
+#ifdef USE_EPOLL
+                // Only a read that would block shows the socket was drained. A short
+                // read can leave the end of the stream behind, if it arrived along
+                // with the data, and epoll won't report it again.
+                if (nErr == WSAEWOULDBLOCK) {
+                    m_nodes_recv_ready.erase(pnode);
+                }
+#endif
                 if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
                 {
                     if (!pnode->fDisconnect) {
@@ -1580,6 +1841,12 @@ void CConnman::SocketHandler()
             if (nBytes) {
                 RecordBytesSent(nBytes);
             }
+#ifdef USE_EPOLL
+            // What's left didn't fit in the socket's buffer, so wait for its next event.
+            if (!pnode->vSendMsg.empty()) {
+                m_nodes_send_ready.erase(pnode);
+            }
+#endif
         }
 
         InactivityCheck(pnode);
@@ -1605,9 +1872,33 @@ void CConnman::WakeMessageHandler()
 {
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = true;
+        vMsgProcWake.assign(vMsgProcWake.size(), true);
     }
-    condMsgProc.notify_one();
+    condMsgProc.notify_all();
+}
+
+void CConnman::WakeMessageHandler(const CNode& node)
+{
+    {
+        LOCK(mutexMsgProc);
+        if (vMsgProcWake.empty()) return;
+        vMsgProcWake[node.GetId() % m_msghandler_threads] = true;
+    }
+    // All threads wait on condMsgProc, so wake all of them for the one
+    // whose flag was set.
+    condMsgProc.notify_all();
+}
+
+void CConnman::WakeSocketHandler()
+{
+#ifdef USE_EPOLL
+    if (m_wakeup_pipe[1] != -1 && !m_wakeup_pending.exchange(true)) {
+        const char c = 0;
+        if (write(m_wakeup_pipe[1], &c, 1) != 1) {
+            m_wakeup_pending = false;
+        }
+    }
+#endif
 }
 
 
@@ -2242,22 +2533,26 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         grantOutbound->MoveTo(pnode->grantOutbound);
 
     m_msgproc->InitializeNode(pnode);
+#ifdef USE_EPOLL
+    RegisterSocketEvents(pnode);
+#endif
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
     }
 }
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(int shard)
 {
     while (!flagInterruptMsgProc)
     {
         std::vector<CNode*> vNodesCopy;
         {
             LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (CNode* pnode : vNodesCopy) {
+            for (CNode* pnode : vNodes) {
+                if (pnode->GetId() % m_msghandler_threads != shard) continue;
                 pnode->AddRef();
+                vNodesCopy.push_back(pnode);
             }
         }
 
@@ -2291,9 +2586,9 @@ void CConnman::ThreadMessageHandler()
 
         WAIT_LOCK(mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return fMsgProcWake; });
+            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this, shard]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return vMsgProcWake[shard]; });
         }
-        fMsgProcWake = false;
+        vMsgProcWake[shard] = false;
     }
 }
 
@@ -2510,6 +2805,17 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         return false;
     }
 
+#ifdef USE_EPOLL
+    if (!InitSocketEvents()) {
+        if (clientInterface) {
+            clientInterface->ThreadSafeMessageBox(
+                _("Failed to initialize socket event handling."),
+                "", CClientUIInterface::MSG_ERROR);
+        }
+        return false;
+    }
+#endif
+
     for (const auto& strDest : connOptions.vSeedNodes) {
         AddAddrFetch(strDest);
     }
@@ -2562,7 +2868,7 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
 
     {
         LOCK(mutexMsgProc);
-        fMsgProcWake = false;
+        vMsgProcWake.assign(m_msghandler_threads, false);
     }
 
     // Send and receive from sockets, accept connections
@@ -2588,7 +2894,12 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         threadOpenConnections = std::thread(&TraceThread<std::function<void()> >, "opencon", std::function<void()>(std::bind(&CConnman::ThreadOpenConnections, this, connOptions.m_specified_outgoing)));
 
     // Process messages
-    threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
+    for (int i = 0; i < m_msghandler_threads; ++i) {
+        const std::string name = m_msghandler_threads == 1 ? "msghand" : strprintf("msghand.%i", i);
+        threadMessageHandlers.emplace_back([this, name, i] {
+            TraceThread(name.c_str(), [this, i] { ThreadMessageHandler(i); });
+        });
+    }
 
     // Dump network addresses
     scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL);
@@ -2620,6 +2931,7 @@ void CConnman::Interrupt()
     condMsgProc.notify_all();
 
     interruptNet();
+    WakeSocketHandler();
     InterruptSocks5(true);
 
     if (semOutbound) {
@@ -2637,8 +2949,11 @@ void CConnman::Interrupt()
 
 void CConnman::StopThreads()
 {
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (std::thread& thread : threadMessageHandlers) {
+        if (thread.joinable())
+            thread.join();
+    }
+    threadMessageHandlers.clear();
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -2684,6 +2999,16 @@ void CConnman::StopNodes()
     vNodes.clear();
     vNodesDisconnected.clear();
     vhListenSocket.clear();
+#ifdef USE_EPOLL
+    m_nodes_recv_ready.clear();
+    m_nodes_send_ready.clear();
+    for (int* fd : {&m_epoll_fd, &m_wakeup_pipe[0], &m_wakeup_pipe[1]}) {
+        if (*fd != -1) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+#endif
     semOutbound.reset();
     semAddnode.reset();
 }
@@ -2696,6 +3021,10 @@ void CConnman::DeleteNode(CNode* pnode)
     if (fUpdateConnectionTime) {
         addrman.Connected(pnode->addr);
     }
+#ifdef USE_EPOLL
+    m_nodes_recv_ready.erase(pnode);
+    m_nodes_send_ready.erase(pnode);
+#endif
     delete pnode;
 }
 
@@ -2741,6 +3070,7 @@ std::vector<CAddress> CConnman::GetAddresses(CNode& requestor, size_t max_addres
         .Write(local_socket_bytes.data(), local_socket_bytes.size())
         .Finalize();
     const auto current_time = GetTime<std::chrono::microseconds>();
+    LOCK(m_addr_response_caches_mutex);
     auto r = m_addr_response_caches.emplace(cache_id, CachedAddrResponse{});
     CachedAddrResponse& cache_entry = r.first->second;
     if (cache_entry.m_cache_entry_expiration < current_time) { // If emplace() added new one it has expiration 0.
@@ -3090,7 +3420,7 @@ int64_t CConnman::PoissonNextSendInbound(int64_t now, int average_interval_secon
     if (m_next_send_inv_to_incoming < now) {
         // If this function were called from multiple threads simultaneously
         // it would possible that both update the next send variable, and return a different result to their caller.
-        // This is not possible in practice as only the net processing thread invokes this function.
+        // This is not possible in practice as the message handler threads only invoke this function with cs_main held.
         m_next_send_inv_to_incoming = PoissonNextSend(now, average_interval_seconds);
     }
     return m_next_send_inv_to_incoming;
@@ -30,6 +30,7 @@
 #include <deque>
 #include <map>
 #include <thread>
+#include <unordered_set>
 #include <memory>
 #include <condition_variable>
 
@@ -88,6 +89,10 @@ static const int64_t DEFAULT_PEER_CONNECT_TIMEOUT = 60;
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Default number of message handler threads, which peers are divided between */
+static const int DEFAULT_MSGHANDLER_THREADS = 1;
+/** Maximum number of message handler threads */
+static const int MAX_MSGHANDLER_THREADS = 16;
 
 typedef int64_t NodeId;
 
@@ -209,6 +214,7 @@ public:
         BanMan* m_banman = nullptr;
         unsigned int nSendBufferMaxSize = 0;
         unsigned int nReceiveFloodSize = 0;
+        int m_msghandler_threads = DEFAULT_MSGHANDLER_THREADS;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
         int64_t m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
@@ -238,6 +244,7 @@ public:
         m_msgproc = connOptions.m_msgproc;
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
+        m_msghandler_threads = std::max(1, std::min(connOptions.m_msghandler_threads, MAX_MSGHANDLER_THREADS));
         m_peer_connect_timeout = connOptions.m_peer_connect_timeout;
         {
             LOCK(cs_totalBytesSent);
@@ -407,7 +414,13 @@ public:
 
     unsigned int GetReceiveFloodSize() const;
 
+    /** Wakes all message handler threads */
     void WakeMessageHandler();
+    /** Wakes the message handler thread that handles the given node */
+    void WakeMessageHandler(const CNode& node);
+
+    /** Interrupts the socket handler's wait for socket events, e.g. when a node may receive again. */
+    void WakeSocketHandler();
 
     /** Attempts to obfuscate tx time through exponentially distributed emitting.
         Works assuming that a single interval is used.
@@ -438,12 +451,17 @@ private:
     void AddAddrFetch(const std::string& strDest);
     void ProcessAddrFetch();
     void ThreadOpenConnections(std::vector<std::string> connect);
-    void ThreadMessageHandler();
+    void ThreadMessageHandler(int shard);
     void AcceptConnection(const ListenSocket& hListenSocket);
     void DisconnectNodes();
     void NotifyNumConnectionsChanged();
     void InactivityCheck(CNode *pnode);
     bool GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
+#ifdef USE_EPOLL
+    bool InitSocketEvents();
+    void RegisterSocketEvents(CNode* pnode);
+    void GenerateReadySet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set);
+#endif
     void SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
     void SocketHandler();
     void ThreadSocketHandler();
@@ -546,7 +564,8 @@ private:
      * resulting in at most ~196 KB. Every separate local socket may
      * add up to ~196 KB extra.
      */
-    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches;
+    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches GUARDED_BY(m_addr_response_caches_mutex);
+    Mutex m_addr_response_caches_mutex;
 
     /**
      * Services this instance offers.
@@ -592,8 +611,14 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake GUARDED_BY(mutexMsgProc);
+    /**
+     * Each node is handled by one message handler thread, picked by its id,
+     * so that messages from different nodes can be processed concurrently.
+     */
+    int m_msghandler_threads{DEFAULT_MSGHANDLER_THREADS};
+
+    /** flags for waking each message handler thread. */
+    std::vector<bool> vMsgProcWake GUARDED_BY(mutexMsgProc);
 
     std::condition_variable condMsgProc;
     Mutex mutexMsgProc;
@@ -601,11 +626,28 @@ private:
 
     CThreadInterrupt interruptNet;
 
+#ifdef USE_EPOLL
+    /** epoll instance the listening sockets, node sockets and m_wakeup_pipe are registered with */
+    int m_epoll_fd{-1};
+    /** Pipe written to by WakeSocketHandler(), to interrupt epoll_wait() */
+    int m_wakeup_pipe[2]{-1, -1};
+    std::atomic<bool> m_wakeup_pending{false};
+
+    /**
+     * Node sockets are registered edge-triggered, so events are only reported
+     * once for each change in their state. These are the nodes whose sockets
+     * may have data to receive, or room to send, since then. Only accessed by
+     * the socket handler thread, and by StopNodes() after it has stopped.
+     */
+    std::unordered_set<CNode*> m_nodes_recv_ready;
+    std::unordered_set<CNode*> m_nodes_send_ready;
+#endif
+
     std::thread threadDNSAddressSeed;
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
+    std::vector<std::thread> threadMessageHandlers;
 
     /** flag for deciding to connect to an extra outbound peer,
      *  in excess of m_max_outbound_full_relay
@@ -754,6 +796,9 @@ public:
     std::string m_command;
 
     CNetMessage(CDataStream&& recv_in) : m_recv(std::move(recv_in)) {}
+    CNetMessage(CNetMessage&&) = default;
+    CNetMessage& operator=(CNetMessage&&) = default;
+    ~CNetMessage();
 
     void SetVersion(int nVersionIn)
     {
@@ -791,21 +836,13 @@ private:
     CDataStream vRecv;              // received message data
     unsigned int nHdrPos;
     unsigned int nDataPos;
+    size_t m_presized_bytes{0};     // payload size vRecv was allocated for up front, if any
 
     const uint256& GetMessageHash() const;
     int readHeader(const char *pch, unsigned int nBytes);
     int readData(const char *pch, unsigned int nBytes);
 
-    void Reset() {
-        vRecv.clear();
-        hdrbuf.clear();
-        hdrbuf.resize(24);
-        in_data = false;
-        nHdrPos = 0;
-        nDataPos = 0;
-        data_hash.SetNull();
-        hasher.Reset();
-    }
+    void Reset();
 
 public:
     V1TransportDeserializer(const CChainParams& chain_params, const NodeId node_id, int nTypeIn, int nVersionIn)
@@ -816,6 +853,7 @@ public:
     {
         Reset();
     }
+    ~V1TransportDeserializer() override;
 
     bool Complete() const override
     {
@@ -1000,7 +1038,9 @@ public:
     std::atomic<int> nStartingHeight{-1};
 
     // flood relay
-    std::vector<CAddress> vAddrToSend;
+    /** Guards vAddrToSend and the contents of m_addr_known, as other nodes' message handler threads relay addresses to this node */
+    Mutex m_addr_send_mutex;
+    std::vector<CAddress> vAddrToSend GUARDED_BY(m_addr_send_mutex);
     std::unique_ptr<CRollingBloomFilter> m_addr_known{nullptr};
     bool fGetAddr{false};
     std::chrono::microseconds m_next_addr_send GUARDED_BY(cs_sendProcessing){0};
@@ -1162,6 +1202,7 @@ public:
 
     void AddAddressKnown(const CAddress& _addr)
     {
+        LOCK(m_addr_send_mutex);
         assert(m_addr_known);
         m_addr_known->insert(_addr.GetKey());
     }
@@ -1176,6 +1217,7 @@ public:
         // Known checking here is only to save space from duplicates.
         // SendMessages will filter it again for knowns that were added
         // after addresses were pushed.
+        LOCK(m_addr_send_mutex);
         assert(m_addr_known);
         if (_addr.IsValid() && !m_addr_known->contains(_addr.GetKey()) && addr_format_supported) {
             if (vAddrToSend.size() >= MAX_ADDR_TO_SEND) {
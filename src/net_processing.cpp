@@ -9,11 +9,13 @@
 #include <banman.h>
 #include <blockencodings.h>
 #include <blockfilter.h>
+#include <blocktranscoder.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <merkleblock.h>
+#include <mweb/mweb_node.h>
 #include <netbase.h>
 #include <netmessagemaker.h>
 #include <policy/fees.h>
@@ -90,10 +92,19 @@ static constexpr auto OVERLOADED_PEER_TX_DELAY = std::chrono::seconds{2};
 static constexpr std::chrono::microseconds GETDATA_TX_INTERVAL{std::chrono::seconds{60}};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Number of blocks that can be requested at any given time from a single peer, until its download speed is known. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
+/** Number of blocks that can be requested at any given time from a single fast peer. */
+static const int MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER = 64;
+/** How long it should take a peer to deliver all the blocks requested from it (in microseconds).
+ *  Each peer's in-flight limit is sized from its measured download speed to match. */
+static const int64_t BLOCK_DOWNLOAD_TARGET_TIME = 2 * 1000000;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
 static const unsigned int BLOCK_STALLING_TIMEOUT = 2;
+/** Time (in microseconds) after which blocks a peer has made no progress delivering may be requested from
+ *  faster peers instead. Less than BLOCK_STALLING_TIMEOUT, so they are usually moved before it would be
+ *  disconnected for stalling. */
+static const int64_t BLOCK_STEAL_TIMEOUT = 1000000;
 /** Number of headers sent in one getheaders result. We rely on the assumption that if a peer sends
  *  less than this number, we reached its tip. Changing this value is a protocol upgrade. */
 static const unsigned int MAX_HEADERS_RESULTS = 2000;
@@ -104,8 +115,8 @@ static const int MAX_CMPCTBLOCK_DEPTH = 5;
 static const int MAX_BLOCKTXN_DEPTH = 10;
 /** Size of the "block download window": how far ahead of our current height do we fetch?
  *  Larger windows tolerate larger download speed differences between peer, but increase the potential
- *  degree of disordering of blocks on disk (which make reindexing and pruning harder). We'll probably
- *  want to make this a per-peer adaptive value at some point. */
+ *  degree of disordering of blocks on disk (which make reindexing and pruning harder). Slow peers are
+ *  kept from holding it back by their smaller in-flight limits, and by moving their requests elsewhere. */
 static const unsigned int BLOCK_DOWNLOAD_WINDOW = 1024;
 /** Block download timeout base, expressed in millionths of the block interval (i.e. 10 min) */
 static const int64_t BLOCK_DOWNLOAD_TIMEOUT_BASE = 1000000;
@@ -320,6 +331,12 @@ struct CNodeState {
     int64_t nDownloadingSince;
     int nBlocksInFlight;
     int nBlocksInFlightValidHeaders;
+    //! Average time (in microseconds) this peer has taken to deliver each requested block, or 0 if not measured yet.
+    int64_t m_block_download_time;
+    //! Average size of the requested blocks this peer has delivered.
+    int64_t m_block_download_size;
+    //! When this peer last delivered a requested block, or was asked for some while it had none in flight (in microseconds).
+    int64_t m_last_block_progress;
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block announcements.
@@ -424,6 +441,9 @@ struct CNodeState {
         nDownloadingSince = 0;
         nBlocksInFlight = 0;
         nBlocksInFlightValidHeaders = 0;
+        m_block_download_time = 0;
+        m_block_download_size = 0;
+        m_last_block_progress = 0;
         fPreferredDownload = false;
         fPreferHeaders = false;
         fPreferHeaderAndIDs = false;
@@ -449,6 +469,18 @@ static CNodeState *State(NodeId pnode) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     return &it->second;
 }
 
+/**
+ * MWEB: Returns the serialization flags for the extension block in cmpctblock,
+ * getblocktxn and blocktxn messages exchanged with this peer.
+ */
+static int GetCmpctMWEBFlags(const CNode& node, const CNodeState& state)
+{
+    if (!state.fWantsCmpctMWEB) {
+        return SERIALIZE_NO_MWEB;
+    }
+    return node.GetCommonVersion() >= MWEB_COMPACT_BLOCKS_VERSION ? SERIALIZE_MWEB_COMPACT : 0;
+}
+
 /**
  * Data structure for an individual peer. This struct is not protected by
  * cs_main since it does not contain validation-critical data.
@@ -547,6 +579,14 @@ static void PushNodeVersion(CNode& pnode, CConnman& connman, int64_t nTime)
     }
 }
 
+/** MWEB: The coins view a block would be connected to, if its parent is the active tip, see PartiallyDownloadedBlock::SetMWEBView. */
+static mw::ICoinsView::Ptr GetMWEBViewForBlock(const CBlockIndex* pindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    if (pindex == nullptr || pindex->pprev == nullptr || pindex->pprev != ::ChainActive().Tip()) {
+        return nullptr;
+    }
+    return ::ChainstateActive().CoinsTip().GetMWEBCacheView();
+}
+
 // Returns a bool indicating whether we requested this block.
 // Also used if a block was /not/ received and timed out or started with another peer
 static bool MarkBlockAsReceived(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
@@ -600,6 +640,7 @@ static bool MarkBlockAsInFlight(CTxMemPool& mempool, NodeId nodeid, const uint25
     if (state->nBlocksInFlight == 1) {
         // We're starting a block download (batch) from this peer.
         state->nDownloadingSince = GetTime<std::chrono::microseconds>().count();
+        state->m_last_block_progress = state->nDownloadingSince;
     }
     if (state->nBlocksInFlightValidHeaders == 1 && pindex != nullptr) {
         nPeersWithValidatedDownloads++;
@@ -610,6 +651,43 @@ static bool MarkBlockAsInFlight(CTxMemPool& mempool, NodeId nodeid, const uint25
     return true;
 }
 
+/** Update a peer's measured download speed with a block it delivered, if it was requested from it. */
+static void RecordBlockDownload(NodeId nodeid, const uint256& hash, size_t size) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
+    if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first != nodeid) {
+        return;
+    }
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+
+    // The peer could only start on this block once it was asked for it, and had delivered the previous one.
+    const int64_t now = GetTime<std::chrono::microseconds>().count();
+    const int64_t elapsed = std::max<int64_t>(1, now - state->m_last_block_progress);
+    if (state->m_block_download_time == 0) {
+        state->m_block_download_time = elapsed;
+        state->m_block_download_size = size;
+    } else {
+        state->m_block_download_time += (elapsed - state->m_block_download_time) / 4;
+        state->m_block_download_size += ((int64_t)size - state->m_block_download_size) / 4;
+    }
+    state->m_last_block_progress = now;
+}
+
+/** Number of blocks that may be in flight from a peer at once: as many as it can deliver in
+ *  BLOCK_DOWNLOAD_TARGET_TIME at the speed it has shown so far. A peer that has been stalling
+ *  is treated as if it will deliver the next block now. */
+static int BlocksInFlightLimit(const CNodeState& state, int64_t now) {
+    int64_t block_download_time = state.m_block_download_time;
+    const int64_t stalled = now - state.m_last_block_progress;
+    if (state.nBlocksInFlight > 0 && stalled > std::max(block_download_time, BLOCK_STEAL_TIMEOUT)) {
+        block_download_time = stalled;
+    }
+    if (block_download_time == 0) {
+        return MAX_BLOCKS_IN_TRANSIT_PER_PEER;
+    }
+    return std::max<int64_t>(2, std::min<int64_t>(MAX_BLOCKS_IN_TRANSIT_PER_FAST_PEER, BLOCK_DOWNLOAD_TARGET_TIME / block_download_time));
+}
+
 /** Check whether the last unknown block a peer advertised is not yet known. */
 static void ProcessBlockAvailability(NodeId nodeid) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     CNodeState *state = State(nodeid);
@@ -802,6 +880,61 @@ static void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vec
     }
 }
 
+/** Add blocks in flight from peers that have made no progress delivering them for a while, and
+ *  that this peer has shown it could deliver sooner, to vBlocks, until it has at most count entries.
+ *  This peer would deliver them after the blocks it already has to deliver, while the stalling
+ *  owner is expected to take at least as long as it has been stalling for each block ahead. */
+static void FindBlocksToSteal(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, const Consensus::Params& consensusParams, int64_t now) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    CNodeState *state = State(nodeid);
+    assert(state != nullptr);
+    // Only a peer whose speed was measured can be expected to deliver sooner.
+    if (vBlocks.size() >= count || state->pindexBestKnownBlock == nullptr || state->m_block_download_time == 0)
+        return;
+    const int64_t thief_eta = (state->nBlocksInFlight + (int64_t)vBlocks.size() + 1) * state->m_block_download_time;
+
+    std::vector<std::pair<const CBlockIndex*, NodeId>> vStalled;
+    for (const auto& entry : mapNodeState) {
+        const NodeId owner = entry.first;
+        const CNodeState& ownerState = entry.second;
+        if (owner == nodeid || ownerState.vBlocksInFlight.empty())
+            continue;
+        const int64_t stalled = now - ownerState.m_last_block_progress;
+        if (stalled < std::max(BLOCK_STEAL_TIMEOUT, 2 * ownerState.m_block_download_time))
+            continue;
+        const int64_t owner_block_time = std::max(ownerState.m_block_download_time, stalled);
+        // The owner's queue is in request order, so its position is counted while walking it.
+        int64_t position = 0;
+        for (const QueuedBlock& queued : ownerState.vBlocksInFlight) {
+            ++position;
+            // Leave compact block reconstructions to the peer that announced the block.
+            if (queued.pindex == nullptr || queued.partialBlock)
+                continue;
+            if (thief_eta >= position * owner_block_time)
+                continue;
+            const CBlockIndex* pindex = queued.pindex;
+            if (state->pindexBestKnownBlock->GetAncestor(pindex->nHeight) != pindex)
+                continue;
+            if ((!state->fHaveWitness && IsWitnessEnabled(pindex->pprev, consensusParams)) ||
+                    (!state->fHaveMWEB && IsMWEBEnabled(pindex->pprev, consensusParams)))
+                continue;
+            vStalled.emplace_back(pindex, owner);
+        }
+    }
+
+    // The lowest blocks hold back the download window the longest.
+    std::sort(vStalled.begin(), vStalled.end(), [](const std::pair<const CBlockIndex*, NodeId>& a, const std::pair<const CBlockIndex*, NodeId>& b) {
+        return a.first->nHeight < b.first->nHeight;
+    });
+    for (const auto& stalled : vStalled) {
+        if (vBlocks.size() >= count)
+            break;
+        LogPrint(BCLog::NET, "Moving request for block %s (%d) from stalling peer=%d to peer=%d\n", stalled.first->GetBlockHash().ToString(),
+            stalled.first->nHeight, stalled.second, nodeid);
+        vBlocks.push_back(stalled.first);
+    }
+}
+
 } // namespace
 
 void PeerManager::AddTxAnnouncement(const CNode& node, const GenTxid& gtxid, std::chrono::microseconds current_time)
@@ -942,6 +1075,10 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
             if (queue.pindex)
                 stats.vHeightInFlight.push_back(queue.pindex->nHeight);
         }
+        stats.m_blocks_in_flight_limit = BlocksInFlightLimit(*state, GetTime<std::chrono::microseconds>().count());
+        if (state->m_block_download_time > 0) {
+            stats.m_block_download_rate = state->m_block_download_size * 1000000 / state->m_block_download_time;
+        }
     }
 
     PeerRef peer = GetPeerRef(nodeid);
@@ -1359,9 +1496,8 @@ void PeerManager::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_
                 !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
 
             bool fPeerWantsWitness = State(pnode->GetId())->fWantsCmpctWitness;
-            bool fPeerWantsMWEB = State(pnode->GetId())->fWantsCmpctMWEB;
             int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-            nSendFlags |= fPeerWantsMWEB ? 0 : SERIALIZE_NO_MWEB;
+            nSendFlags |= GetCmpctMWEBFlags(*pnode, state);
 
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
@@ -1613,14 +1749,28 @@ void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, c
         std::shared_ptr<const CBlock> pblock;
         if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
             pblock = a_recent_block;
-        } else if (inv.IsMsgMWEBBlk()) {
+        } else if (inv.IsMsgMWEBBlk() || inv.IsMsgWitnessBlk() || inv.IsMsgBlk()) {
             // Fast-path: in this case it is possible to serve the block directly from disk,
-            // as the network format matches the format on disk
+            // as the network format matches the format on disk. Witnesses and MWEB data the
+            // peer didn't ask for are stripped from the raw block, without deserializing it.
             std::vector<uint8_t> block_data;
             if (!ReadRawBlockFromDisk(block_data, pindex, chainparams.MessageStart())) {
                 assert(!"cannot load block from disk");
             }
-            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, MakeSpan(block_data)));
+            CSerializedNetMsg msg;
+            msg.m_type = NetMsgType::BLOCK;
+            if (inv.IsMsgMWEBBlk()) {
+                msg.data = std::move(block_data);
+            } else {
+                const int serialize_flags = SERIALIZE_NO_MWEB | (inv.IsMsgBlk() ? SERIALIZE_TRANSACTION_NO_WITNESS : 0);
+                if (!TranscodeBlock(block_data, serialize_flags, msg.data)) {
+                    // Fall back to a full round trip through CBlock.
+                    std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+                    VectorReader(SER_NETWORK, PROTOCOL_VERSION, block_data, 0) >> *pblockRead;
+                    msg = msgMaker.Make(serialize_flags, NetMsgType::BLOCK, *pblockRead);
+                }
+            }
+            connman.PushMessage(&pfrom, std::move(msg));
             // Don't set pblock as we've sent the block
         } else {
             // Send block from disk
@@ -1668,7 +1818,7 @@ void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, c
                 bool fPeerWantsWitness = State(pfrom.GetId())->fWantsCmpctWitness;
                 bool fPeerWantsMWEB = State(pfrom.GetId())->fWantsCmpctMWEB;
                 int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-                nSendFlags |= fPeerWantsMWEB ? 0 : SERIALIZE_NO_MWEB;
+                nSendFlags |= GetCmpctMWEBFlags(pfrom, *State(pfrom.GetId()));
 
                 if (CanDirectFetch(consensusParams) && pindex->nHeight >= ::ChainActive().Height() - MAX_CMPCTBLOCK_DEPTH) {
                     if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) && (fPeerWantsMWEB || !fMWEBPresentInARecentCompactBlock) && a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
@@ -1840,10 +1990,36 @@ void PeerManager::SendBlockTransactions(CNode& pfrom, const CBlock& block, const
         }
         resp.txn[i] = block.vtx[req.indexes[i]];
     }
+
+    // MWEB: Fill in the requested extension block components
+    const size_t num_inputs = block.mweb_block.IsNull() ? 0 : block.mweb_block.m_block->GetInputs().size();
+    const size_t num_outputs = block.mweb_block.IsNull() ? 0 : block.mweb_block.m_block->GetOutputs().size();
+    const size_t num_kernels = block.mweb_block.IsNull() ? 0 : block.mweb_block.m_block->GetKernels().size();
+    for (size_t i = 0; i < req.mweb_input_indexes.size(); i++) {
+        if (req.mweb_input_indexes[i] >= num_inputs) {
+            Misbehaving(pfrom.GetId(), 100, "getblocktxn with out-of-bounds mweb input indices");
+            return;
+        }
+        resp.mweb_inputs[i] = block.mweb_block.m_block->GetInputs()[req.mweb_input_indexes[i]];
+    }
+    for (size_t i = 0; i < req.mweb_output_indexes.size(); i++) {
+        if (req.mweb_output_indexes[i] >= num_outputs) {
+            Misbehaving(pfrom.GetId(), 100, "getblocktxn with out-of-bounds mweb output indices");
+            return;
+        }
+        resp.mweb_outputs[i] = block.mweb_block.m_block->GetOutputs()[req.mweb_output_indexes[i]];
+    }
+    for (size_t i = 0; i < req.mweb_kernel_indexes.size(); i++) {
+        if (req.mweb_kernel_indexes[i] >= num_kernels) {
+            Misbehaving(pfrom.GetId(), 100, "getblocktxn with out-of-bounds mweb kernel indices");
+            return;
+        }
+        resp.mweb_kernels[i] = block.mweb_block.m_block->GetKernels()[req.mweb_kernel_indexes[i]];
+    }
     LOCK(cs_main);
     const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
     int nSendFlags = State(pfrom.GetId())->fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-    nSendFlags |= State(pfrom.GetId())->fWantsCmpctMWEB ? 0 : SERIALIZE_NO_MWEB;
+    nSendFlags |= GetCmpctMWEBFlags(pfrom, *State(pfrom.GetId()));
 
     m_connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCKTXN, resp));
 }
@@ -1971,7 +2147,7 @@ void PeerManager::ProcessHeadersMessage(CNode& pfrom, const std::vector<CBlockHe
                 std::vector<CInv> vGetData;
                 // Download as much as possible, from earliest to latest.
                 for (const CBlockIndex *pindex : reverse_iterate(vToFetch)) {
-                    if (nodestate->nBlocksInFlight >= MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+                    if (nodestate->nBlocksInFlight >= BlocksInFlightLimit(*nodestate, GetTime<std::chrono::microseconds>().count())) {
                         // Can't download any more from this peer
                         break;
                     }
@@ -2932,6 +3108,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
     }
 
     if (msg_type == NetMsgType::GETBLOCKTXN) {
+        WITH_LOCK(cs_main, vRecv.SetVersion(vRecv.GetVersion() | GetCmpctMWEBFlags(pfrom, *State(pfrom.GetId()))));
         BlockTransactionsRequest req;
         vRecv >> req;
 
@@ -3068,6 +3245,22 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         const uint256& txid = ptx->GetHash();
         const uint256& wtxid = ptx->GetWitnessHash();
 
+        // Verify MWEB data before taking cs_main for long, so that other
+        // peers' messages can be handled meanwhile. AcceptToMemoryPool won't
+        // verify it again. Transactions we already have or recently rejected
+        // are not verified, so that peers can't make us repeat the work.
+        TxValidationState mweb_state;
+        if (tx.HasMWEBTx()) {
+            bool already_have;
+            {
+                LOCK(cs_main);
+                already_have = AlreadyHaveTx(GenTxid(/* is_wtxid=*/true, wtxid), m_mempool);
+            }
+            if (!already_have) {
+                MWEB::Node::CheckTransaction(tx, mweb_state);
+            }
+        }
+
         LOCK2(cs_main, g_cs_orphans);
 
         CNodeState* nodestate = State(pfrom.GetId());
@@ -3116,7 +3309,16 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         TxValidationState state;
         std::list<CTransactionRef> lRemovedTxn;
 
-        if (AcceptToMemoryPool(m_mempool, state, ptx, &lRemovedTxn, false /* bypass_limits */)) {
+        bool accepted = false;
+        if (mweb_state.IsInvalid()) {
+            // Handle invalid MWEB data like any other rejection, so that the
+            // transaction ends up in recentRejects and the peer is punished.
+            state = mweb_state;
+        } else {
+            accepted = AcceptToMemoryPool(m_mempool, state, ptx, &lRemovedTxn, false /* bypass_limits */);
+        }
+
+        if (accepted) {
             m_mempool.check(&::ChainstateActive().CoinsTip());
             // As this version of the transaction was acceptable, we can forget about any
             // requests for it.
@@ -3278,9 +3480,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             LOCK(cs_main);
             CBlockIndex* pTip = ::ChainActive().Tip();
             assert(pTip);
-            if (!State(pfrom.GetId())->fWantsCmpctMWEB) {
-                vRecv.SetVersion(vRecv.GetVersion() | SERIALIZE_NO_MWEB);
-            }
+            vRecv.SetVersion(vRecv.GetVersion() | GetCmpctMWEBFlags(pfrom, *State(pfrom.GetId())));
         }
 
         CBlockHeaderAndShortTxIDs cmpctblock;
@@ -3411,7 +3611,8 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
                     if (!partialBlock.IsTxAvailable(i))
                         req.indexes.push_back(i);
                 }
-                if (req.indexes.empty()) {
+                partialBlock.GetMissingMWEBIndexes(req);
+                if (req.IsEmpty()) {
                     // Dirty hack to jump to BLOCKTXN code (TODO: move message handling into their own functions)
                     BlockTransactions txn;
                     txn.blockhash = cmpctblock.header.GetHash();
@@ -3419,7 +3620,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
                     fProcessBLOCKTXN = true;
                 } else {
                     req.blockhash = pindex->GetBlockHash();
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETBLOCKTXN, req));
+                    m_connman.PushMessage(&pfrom, msgMaker.Make(GetCmpctMWEBFlags(pfrom, *nodestate), NetMsgType::GETBLOCKTXN, req));
                 }
             } else {
                 // This block is either already in flight from a different
@@ -3434,6 +3635,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
                     return;
                 }
                 std::vector<CTransactionRef> dummy;
+                tempBlock.SetMWEBView(GetMWEBViewForBlock(pindex));
                 status = tempBlock.FillBlock(*pblock, dummy);
                 if (status == READ_STATUS_OK) {
                     fBlockReconstructed = true;
@@ -3511,6 +3713,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             return;
         }
 
+        WITH_LOCK(cs_main, vRecv.SetVersion(vRecv.GetVersion() | GetCmpctMWEBFlags(pfrom, *State(pfrom.GetId()))));
         BlockTransactions resp;
         vRecv >> resp;
 
@@ -3527,7 +3730,8 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             }
 
             PartiallyDownloadedBlock& partialBlock = *it->second.second->partialBlock;
-            ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn);
+            partialBlock.SetMWEBView(GetMWEBViewForBlock(it->second.second->pindex));
+            ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn, resp.mweb_inputs, resp.mweb_outputs, resp.mweb_kernels);
             if (status == READ_STATUS_INVALID) {
                 MarkBlockAsReceived(resp.blockhash); // Reset in-flight state in case Misbehaving does not result in a disconnect
                 Misbehaving(pfrom.GetId(), 100, "invalid compact block/non-matching block transactions");
@@ -3618,6 +3822,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             return;
         }
 
+        const size_t nBlockSize = vRecv.size();
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
         vRecv >> *pblock;
 
@@ -3627,6 +3832,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         const uint256 hash(pblock->GetHash());
         {
             LOCK(cs_main);
+            RecordBlockDownload(pfrom.GetId(), hash, nBlockSize);
             // Also always process if we requested the block explicitly, as we may
             // need it even though it is not a candidate for a new best tip.
             forceProcessing |= MarkBlockAsReceived(hash);
@@ -3665,7 +3871,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         }
         pfrom.fSentAddr = true;
 
-        pfrom.vAddrToSend.clear();
+        WITH_LOCK(pfrom.m_addr_send_mutex, pfrom.vAddrToSend.clear());
         std::vector<CAddress> vAddr;
         if (pfrom.HasPermission(PF_ADDR)) {
             vAddr = m_connman.GetAddresses(MAX_ADDR_TO_SEND, MAX_PCT_ADDR_TO_SEND);
@@ -3978,6 +4184,7 @@ bool PeerManager::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgP
         return false;
 
     std::list<CNetMessage> msgs;
+    bool fResumeRecv = false;
     {
         LOCK(pfrom->cs_vProcessMsg);
         if (pfrom->vProcessMsg.empty())
@@ -3985,9 +4192,15 @@ bool PeerManager::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgP
         // Just take one message
         msgs.splice(msgs.begin(), pfrom->vProcessMsg, pfrom->vProcessMsg.begin());
         pfrom->nProcessQueueSize -= msgs.front().m_raw_message_size;
+        const bool fPausedRecv = pfrom->fPauseRecv;
         pfrom->fPauseRecv = pfrom->nProcessQueueSize > m_connman.GetReceiveFloodSize();
+        fResumeRecv = fPausedRecv && !pfrom->fPauseRecv;
         fMoreWork = !pfrom->vProcessMsg.empty();
     }
+    if (fResumeRecv) {
+        // Its socket may not report any more events until it's read from again.
+        m_connman.WakeSocketHandler();
+    }
     CNetMessage& msg(msgs.front());
 
     msg.SetVersion(pfrom->GetCommonVersion());
@@ -4228,6 +4441,7 @@ bool PeerManager::SendMessages(CNode* pto)
         //
         if (pto->RelayAddrsWithConn() && pto->m_next_addr_send < current_time) {
             pto->m_next_addr_send = PoissonNextSend(current_time, AVG_ADDRESS_BROADCAST_INTERVAL);
+            LOCK(pto->m_addr_send_mutex);
             std::vector<CAddress> vAddr;
             vAddr.reserve(pto->vAddrToSend.size());
             assert(pto->m_addr_known);
@@ -4363,7 +4577,7 @@ bool PeerManager::SendMessages(CNode* pto)
                             vHeaders.front().GetHash().ToString(), pto->GetId());
 
                     int nSendFlags = state.fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-                    nSendFlags |= state.fWantsCmpctMWEB ? 0 : SERIALIZE_NO_MWEB;
+                    nSendFlags |= GetCmpctMWEBFlags(*pto, state);
 
                     bool fGotBlockFromCache = false;
                     {
@@ -4654,10 +4868,12 @@ bool PeerManager::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (!pto->fClient && ((fFetch && !pto->m_limited_node) || !::ChainstateActive().IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        const int nBlocksInFlightLimit = BlocksInFlightLimit(state, count_microseconds(current_time));
+        if (!pto->fClient && ((fFetch && !pto->m_limited_node) || !::ChainstateActive().IsInitialBlockDownload()) && state.nBlocksInFlight < nBlocksInFlightLimit) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller, consensusParams);
+            FindNextBlocksToDownload(pto->GetId(), nBlocksInFlightLimit - state.nBlocksInFlight, vToDownload, staller, consensusParams);
+            FindBlocksToSteal(pto->GetId(), nBlocksInFlightLimit - state.nBlocksInFlight, vToDownload, consensusParams, count_microseconds(current_time));
             for (const CBlockIndex *pindex : vToDownload) {
                 uint32_t nFetchFlags = GetFetchFlags(*pto);
                 vGetData.push_back(CInv(MSG_BLOCK | nFetchFlags, pindex->GetBlockHash()));
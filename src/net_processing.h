@@ -150,6 +150,8 @@ struct CNodeStateStats {
     int nSyncHeight = -1;
     int nCommonHeight = -1;
     std::vector<int> vHeightInFlight;
+    int m_blocks_in_flight_limit = 0;
+    int64_t m_block_download_rate = 0;
     uint64_t m_addr_processed = 0;
     uint64_t m_addr_rate_limited = 0;
 };
@@ -8,6 +8,19 @@
 
 #include <uint256.h>
 #include <serialize.h>
+#include <span.h>
+#include <tinyformat.h>
+#include <mw/models/block/Header.h>
+
+#include <array>
+#include <ios>
+
+//! Written ahead of the metadata, so that files that aren't snapshots, including
+//! snapshots written before the format was versioned, are told apart.
+static constexpr std::array<uint8_t, 5> SNAPSHOT_MAGIC_BYTES = {'u', 't', 'x', 'o', 0xff};
+
+//! Version of the snapshot format. Version 1 added the MWEB header and UTXO count.
+static constexpr uint16_t SNAPSHOT_VERSION = 1;
 
 //! Metadata describing a serialized version of a UTXO set from which an
 //! assumeutxo CChainState can be constructed.
@@ -26,16 +39,51 @@ public:
     //! initial block download for the assumeutxo chainstate.
     unsigned int m_nchaintx = 0;
 
+    //! MWEB: The extension block header at the base of the snapshot, or null if
+    //! MWEB wasn't active yet. When set, the transparent coins are followed by the
+    //! MWEB leafset, compacted output MMR and UTXOs (see mw::SnapshotWriter).
+    mw::Header::CPtr m_mweb_header;
+
+    //! MWEB: The number of MWEB UTXOs contained in this snapshot.
+    uint64_t m_mweb_coins_count = 0;
+
     SnapshotMetadata() { }
     SnapshotMetadata(
         const uint256& base_blockhash,
         uint64_t coins_count,
-        unsigned int nchaintx) :
+        unsigned int nchaintx,
+        const mw::Header::CPtr& mweb_header = nullptr,
+        uint64_t mweb_coins_count = 0) :
             m_base_blockhash(base_blockhash),
             m_coins_count(coins_count),
-            m_nchaintx(nchaintx) { }
+            m_nchaintx(nchaintx),
+            m_mweb_header(mweb_header),
+            m_mweb_coins_count(mweb_coins_count) { }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << MakeSpan(SNAPSHOT_MAGIC_BYTES) << SNAPSHOT_VERSION;
+        s << m_base_blockhash << m_coins_count << m_nchaintx;
+        s << WrapOptionalPtr(m_mweb_header) << m_mweb_coins_count;
+    }
 
-    SERIALIZE_METHODS(SnapshotMetadata, obj) { READWRITE(obj.m_base_blockhash, obj.m_coins_count, obj.m_nchaintx); }
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        std::array<uint8_t, SNAPSHOT_MAGIC_BYTES.size()> magic;
+        s >> MakeSpan(magic);
+        if (magic != SNAPSHOT_MAGIC_BYTES) {
+            throw std::ios_base::failure("Invalid UTXO set snapshot magic bytes. Please check if this is indeed a snapshot file or if you are using an outdated snapshot format.");
+        }
+        uint16_t version;
+        s >> version;
+        if (version != SNAPSHOT_VERSION) {
+            throw std::ios_base::failure(strprintf("Version of snapshot %d does not match the supported version %d.", version, SNAPSHOT_VERSION));
+        }
+        s >> m_base_blockhash >> m_coins_count >> m_nchaintx;
+        s >> WrapOptionalPtr(m_mweb_header) >> m_mweb_coins_count;
+    }
 };
 
 #endif // BITCOIN_NODE_UTXO_SNAPSHOT_H
@@ -0,0 +1 @@
+#define BUILD_GIT_COMMIT "2736e32-dirty"
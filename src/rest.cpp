@@ -3,15 +3,19 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <blocktranscoder.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <crypto/common.h>
 #include <httpserver.h>
 #include <index/txindex.h>
+#include <mweb/mweb_node.h>
 #include <node/context.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <streams.h>
@@ -28,6 +32,8 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const int32_t MAX_REST_BLOCKS = 2000; //allow a max of 2000 blocks to be exported at once
+static const size_t REST_BLOCKS_CHUNK_SIZE = 64 * 1024; //send exported blocks in pieces of at least 64 KB
 
 enum class RetFormat {
     UNDEF,
@@ -279,10 +285,11 @@ static bool rest_block(HTTPRequest* req,
     }
 
     case RetFormat::JSON: {
-        UniValue objBlock = blockToJSON(block, tip, pblockindex, showTxDetails);
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        HTTPReplyStream stream(req, HTTP_OK, "application/json");
+        JSONStreamWriter writer([&stream](std::string&& chunk) { stream.Write(std::move(chunk)); });
+        blockToJSON(writer, block, tip, pblockindex, showTxDetails);
+        writer.Flush();
+        stream.End("\n");
         return true;
     }
 
@@ -302,6 +309,119 @@ static bool rest_block_notxdetails(const util::Ref& context, HTTPRequest* req, c
     return rest_block(req, strURIPart, false);
 }
 
+/** Appends a record of the exported blocks: its size as a 32 bit little endian integer, followed by its data. */
+static void AppendBlocksRecord(std::string& out, Span<const uint8_t> data)
+{
+    uint8_t size[4];
+    WriteLE32(size, data.size());
+    out.append((const char*)size, sizeof(size));
+    out.append((const char*)data.data(), data.size());
+}
+
+static bool rest_blocks(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY) {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: bin)");
+    }
+
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+    if (path.size() < 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "No block range specified. Use /rest/blocks/[undo/][nomweb/]<start>/<count>.bin.");
+    }
+
+    bool with_undo = false;
+    int serialize_flags = 0;
+    for (size_t i = 0; i + 2 < path.size(); ++i) {
+        if (path[i] == "undo" && !with_undo) {
+            with_undo = true;
+        } else if (path[i] == "nomweb" && !serialize_flags) {
+            serialize_flags = SERIALIZE_NO_MWEB;
+        } else {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid option: " + SanitizeString(path[i]));
+        }
+    }
+
+    const std::string& start_str = path[path.size() - 2];
+    const std::string& count_str = path[path.size() - 1];
+    int32_t start = -1;
+    if (!ParseInt32(start_str, &start) || start < 0) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(start_str));
+    }
+    int32_t count = 0;
+    if (!ParseInt32(count_str, &count) || count < 1 || count > MAX_REST_BLOCKS) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + SanitizeString(count_str));
+    }
+
+    // The range ends early at the tip of the active chain
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = ::ChainActive();
+        if (start > active_chain.Height()) {
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        }
+        for (int height = start; height <= active_chain.Height() && blocks.size() < (size_t)count; ++height) {
+            const CBlockIndex* pindex = active_chain[height];
+            if (IsBlockPruned(pindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND, strprintf("Block at height %d not available (pruned data)", height));
+            }
+            blocks.push_back(pindex);
+        }
+    }
+
+    HTTPReplyStream stream(req, HTTP_OK, "application/octet-stream");
+    RawBlockReader reader(Params().MessageStart());
+    std::vector<uint8_t> block_data, undo_data, transcoded;
+    std::string piece;
+    for (const CBlockIndex* pindex : blocks) {
+        if (!reader.Read(pindex, with_undo, block_data, undo_data)) {
+            // The block was pruned since the request arrived.
+            if (!stream.Started()) {
+                return RESTERR(req, HTTP_NOT_FOUND, strprintf("Block at height %d not available", pindex->nHeight));
+            }
+            // Ending the reply would make the blocks sent so far look like
+            // the whole range, so close the connection instead.
+            req->AbortReply();
+            return false;
+        }
+        if (serialize_flags) {
+            if (!TranscodeBlock(block_data, serialize_flags, transcoded)) {
+                // Fall back to a full round trip through CBlock.
+                CBlock block;
+                try {
+                    VectorReader(SER_DISK, CLIENT_VERSION, block_data, 0) >> block;
+                } catch (const std::exception&) {
+                    if (!stream.Started()) {
+                        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, strprintf("Block at height %d could not be read", pindex->nHeight));
+                    }
+                    // Ending the reply would make the blocks sent so far look
+                    // like the whole range, so close the connection instead.
+                    req->AbortReply();
+                    return false;
+                }
+                transcoded.clear();
+                CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | serialize_flags, transcoded, 0, block);
+            }
+            std::swap(block_data, transcoded);
+        }
+        AppendBlocksRecord(piece, block_data);
+        if (with_undo) AppendBlocksRecord(piece, undo_data);
+        if (piece.size() >= REST_BLOCKS_CHUNK_SIZE) {
+            const bool delivering = stream.Write(std::move(piece));
+            piece.clear();
+            if (!delivering) break; // the client went away
+        }
+    }
+    stream.Write(std::move(piece));
+    stream.End();
+    return true;
+}
+
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
 RPCHelpMan getblockchaininfo();
 
@@ -362,11 +482,11 @@ static bool rest_mempool_contents(const util::Ref& context, HTTPRequest* req, co
 
     switch (rf) {
     case RetFormat::JSON: {
-        UniValue mempoolObject = MempoolToJSON(*mempool, true);
-
-        std::string strJSON = mempoolObject.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        HTTPReplyStream stream(req, HTTP_OK, "application/json");
+        JSONStreamWriter writer([&stream](std::string&& chunk) { stream.Write(std::move(chunk)); });
+        MempoolToJSON(writer, *mempool, true);
+        writer.Flush();
+        stream.End("\n");
         return true;
     }
     default: {
@@ -620,6 +740,83 @@ static bool rest_getutxos(const util::Ref& context, HTTPRequest* req, const std:
     }
 }
 
+static bool rest_mwebutxoproof(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    std::vector<std::string> uriParts;
+    if (param.length() > 1) {
+        boost::split(uriParts, param.substr(1), boost::is_any_of("/"));
+    }
+
+    if (uriParts.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+    }
+
+    const size_t max_outputs = MWEB::Node::MaxUTXOProofOutputs();
+    if (uriParts.size() > max_outputs) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Error: max outputs exceeded (max: %d, tried: %d)", max_outputs, uriParts.size()));
+    }
+
+    std::set<mw::Hash> output_ids;
+    for (const std::string& strOutputID : uriParts) {
+        if (strOutputID.size() != 64 || !IsHex(strOutputID)) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+        output_ids.insert(mw::Hash::FromHex(strOutputID));
+    }
+
+    MWEB::UTXOProof proof;
+    try {
+        LOCK(cs_main);
+        std::string error;
+        if (!MWEB::Node::BuildUTXOProof(::ChainstateActive(), {output_ids.begin(), output_ids.end()}, proof, error)) {
+            return RESTERR(req, HTTP_NOT_FOUND, error);
+        }
+    } catch (const std::exception& e) {
+        // The proof is built from the MWEB coins view, which throws if its data can't be read
+        return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, strprintf("Error: failed to build proof: %s", e.what()));
+    }
+
+    CDataStream ssProof(SER_NETWORK, PROTOCOL_VERSION);
+    ssProof << proof;
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ssProof.str());
+        return true;
+    }
+
+    case RetFormat::HEX: {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ssProof) + "\n");
+        return true;
+    }
+
+    case RetFormat::JSON: {
+        UniValue objProof(UniValue::VOBJ);
+        objProof.pushKV("blockhash", proof.block_hash.GetHex());
+        UniValue ids(UniValue::VARR);
+        for (const mw::Hash& output_id : proof.output_ids) {
+            ids.push_back(output_id.ToHex());
+        }
+        objProof.pushKV("output_ids", ids);
+        objProof.pushKV("proof", HexStr(ssProof));
+
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, objProof.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static bool rest_blockhash_by_height(const util::Ref& context, HTTPRequest* req,
                        const std::string& str_uri_part)
 {
@@ -666,12 +863,66 @@ static bool rest_blockhash_by_height(const util::Ref& context, HTTPRequest* req,
     }
 }
 
+// A bit of a hack - dependency on functions defined in rpc/blockchain.cpp
+RPCHelpMan getaddresshistory();
+RPCHelpMan getaddressutxos();
+
+static bool rest_address(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() < 3 || path.size() > 4 || (path[0] != "history" && path[0] != "utxos")) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/address/<history|utxos>/<count>/<address>[/<cursor>].json.");
+    }
+
+    int32_t count;
+    if (!ParseInt32(path[1], &count)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid count: " + SanitizeString(path[1]));
+    }
+
+    switch (rf) {
+    case RetFormat::JSON: {
+        JSONRPCRequest jsonRequest(context);
+        jsonRequest.params = UniValue(UniValue::VARR);
+        jsonRequest.params.push_back(path[2]);
+        jsonRequest.params.push_back(count);
+        if (path.size() == 4) jsonRequest.params.push_back(path[3]);
+
+        UniValue result;
+        try {
+            result = (path[0] == "history" ? getaddresshistory() : getaddressutxos()).HandleRequest(jsonRequest);
+        } catch (const UniValue& objError) {
+            const int code = find_value(objError, "code").get_int();
+            const std::string& message = find_value(objError, "message").get_str();
+            switch (code) {
+            case RPC_MISC_ERROR: return RESTERR(req, HTTP_NOT_FOUND, message);
+            case RPC_IN_WARMUP: return RESTERR(req, HTTP_SERVICE_UNAVAILABLE, message);
+            case RPC_DATABASE_ERROR: return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, message);
+            default: return RESTERR(req, HTTP_BAD_REQUEST, message);
+            }
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, result.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const util::Ref& context, HTTPRequest* req, const std::string& strReq);
 } uri_prefixes[] = {
       {"/rest/tx/", rest_tx},
       {"/rest/block/notxdetails/", rest_block_notxdetails},
+      {"/rest/blocks/", rest_blocks},
       {"/rest/block/", rest_block_extended},
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/info", rest_mempool_info},
@@ -679,6 +930,8 @@ static const struct {
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/mwebutxoproof", rest_mwebutxoproof},
+      {"/rest/address/", rest_address},
 };
 
 void StartREST(const util::Ref& context)
@@ -13,7 +13,10 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <hash.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
+#include <key_io.h>
+#include <mw/node/Snapshot.h>
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
@@ -21,9 +24,11 @@
 #include <policy/policy.h>
 #include <policy/rbf.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
+#include <script/standard.h>
 #include <streams.h>
 #include <sync.h>
 #include <txdb.h>
@@ -146,17 +151,18 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     result.pushKV("chainwork", blockindex->nChainWork.GetHex());
     result.pushKV("nTx", (uint64_t)blockindex->nTx);
 
-    if (blockindex->mweb_header != nullptr) {
+    const mw::Header::CPtr header = GetMWEBHeader(blockindex);
+    if (header != nullptr) {
         UniValue mweb_header(UniValue::VOBJ);
-        mweb_header.pushKV("hash", blockindex->mweb_header->GetHash().ToHex());
-        mweb_header.pushKV("height", blockindex->mweb_header->GetHeight());
-        mweb_header.pushKV("kernel_offset", blockindex->mweb_header->GetKernelOffset().ToHex());
-        mweb_header.pushKV("stealth_offset", blockindex->mweb_header->GetStealthOffset().ToHex());
-        mweb_header.pushKV("num_kernels", blockindex->mweb_header->GetNumKernels());
-        mweb_header.pushKV("num_txos", blockindex->mweb_header->GetNumTXOs());
-        mweb_header.pushKV("kernel_root", blockindex->mweb_header->GetKernelRoot().ToHex());
-        mweb_header.pushKV("output_root", blockindex->mweb_header->GetOutputRoot().ToHex());
-        mweb_header.pushKV("leaf_root", blockindex->mweb_header->GetLeafsetRoot().ToHex());
+        mweb_header.pushKV("hash", header->GetHash().ToHex());
+        mweb_header.pushKV("height", header->GetHeight());
+        mweb_header.pushKV("kernel_offset", header->GetKernelOffset().ToHex());
+        mweb_header.pushKV("stealth_offset", header->GetStealthOffset().ToHex());
+        mweb_header.pushKV("num_kernels", header->GetNumKernels());
+        mweb_header.pushKV("num_txos", header->GetNumTXOs());
+        mweb_header.pushKV("kernel_root", header->GetKernelRoot().ToHex());
+        mweb_header.pushKV("output_root", header->GetOutputRoot().ToHex());
+        mweb_header.pushKV("leaf_root", header->GetLeafsetRoot().ToHex());
         result.pushKV("mweb_header", mweb_header);
 
         result.pushKV("mweb_amount", blockindex->mweb_amount);
@@ -172,60 +178,63 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
+void blockToJSON(JSONWriter& writer, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
 {
     // Serialize passed information without accessing chain state of the active chain!
     AssertLockNotHeld(cs_main); // For performance reasons
 
-    UniValue result(UniValue::VOBJ);
-    result.pushKV("hash", blockindex->GetBlockHash().GetHex());
+    writer.BeginObject();
+    writer.KV("hash", blockindex->GetBlockHash().GetHex());
     const CBlockIndex* pnext;
     int confirmations = ComputeNextBlockAndDepth(tip, blockindex, pnext);
-    result.pushKV("confirmations", confirmations);
-    result.pushKV("strippedsize", (int)::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB));
-    result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
-    result.pushKV("weight", (int)::GetBlockWeight(block));
-    result.pushKV("height", blockindex->nHeight);
-    result.pushKV("version", block.nVersion);
-    result.pushKV("versionHex", strprintf("%08x", block.nVersion));
-    result.pushKV("merkleroot", block.hashMerkleRoot.GetHex());
-    UniValue txs(UniValue::VARR);
+    writer.KV("confirmations", confirmations);
+    writer.KV("strippedsize", (int)::GetSerializeSize(block, PROTOCOL_VERSION | SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB));
+    writer.KV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
+    writer.KV("weight", (int)::GetBlockWeight(block));
+    writer.KV("height", blockindex->nHeight);
+    writer.KV("version", block.nVersion);
+    writer.KV("versionHex", strprintf("%08x", block.nVersion));
+    writer.KV("merkleroot", block.hashMerkleRoot.GetHex());
+    writer.Key("tx");
+    writer.BeginArray();
     for(const auto& tx : block.vtx)
     {
         if(txDetails)
         {
             UniValue objTx(UniValue::VOBJ);
             TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags());
-            txs.push_back(objTx);
+            writer.Value(objTx);
         }
         else
-            txs.push_back(tx->GetHash().GetHex());
+            writer.Value(tx->GetHash().GetHex());
     }
-    result.pushKV("tx", txs);
-    result.pushKV("time", block.GetBlockTime());
-    result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
-    result.pushKV("nonce", (uint64_t)block.nNonce);
-    result.pushKV("bits", strprintf("%08x", block.nBits));
-    result.pushKV("difficulty", GetDifficulty(blockindex));
-    result.pushKV("chainwork", blockindex->nChainWork.GetHex());
-    result.pushKV("nTx", (uint64_t)blockindex->nTx);
+    writer.EndArray();
+    writer.KV("time", block.GetBlockTime());
+    writer.KV("mediantime", (int64_t)blockindex->GetMedianTimePast());
+    writer.KV("nonce", (uint64_t)block.nNonce);
+    writer.KV("bits", strprintf("%08x", block.nBits));
+    writer.KV("difficulty", GetDifficulty(blockindex));
+    writer.KV("chainwork", blockindex->nChainWork.GetHex());
+    writer.KV("nTx", (uint64_t)blockindex->nTx);
 
     if (!block.mweb_block.IsNull()) {
-        UniValue mweb_block(UniValue::VOBJ);
+        writer.Key("mweb");
+        writer.BeginObject();
 
         // MWEB Header
-        mweb_block.pushKV("hash", block.mweb_block.GetMWEBHeader()->GetHash().ToHex());
-        mweb_block.pushKV("height", block.mweb_block.GetMWEBHeader()->GetHeight());
-        mweb_block.pushKV("kernel_offset", block.mweb_block.GetMWEBHeader()->GetKernelOffset().ToHex());
-        mweb_block.pushKV("stealth_offset", block.mweb_block.GetMWEBHeader()->GetStealthOffset().ToHex());
-        mweb_block.pushKV("num_kernels", block.mweb_block.GetMWEBHeader()->GetNumKernels());
-        mweb_block.pushKV("num_txos", block.mweb_block.GetMWEBHeader()->GetNumTXOs());
-        mweb_block.pushKV("kernel_root", block.mweb_block.GetMWEBHeader()->GetKernelRoot().ToHex());
-        mweb_block.pushKV("output_root", block.mweb_block.GetMWEBHeader()->GetOutputRoot().ToHex());
-        mweb_block.pushKV("leaf_root", block.mweb_block.GetMWEBHeader()->GetLeafsetRoot().ToHex());
+        writer.KV("hash", block.mweb_block.GetMWEBHeader()->GetHash().ToHex());
+        writer.KV("height", block.mweb_block.GetMWEBHeader()->GetHeight());
+        writer.KV("kernel_offset", block.mweb_block.GetMWEBHeader()->GetKernelOffset().ToHex());
+        writer.KV("stealth_offset", block.mweb_block.GetMWEBHeader()->GetStealthOffset().ToHex());
+        writer.KV("num_kernels", block.mweb_block.GetMWEBHeader()->GetNumKernels());
+        writer.KV("num_txos", block.mweb_block.GetMWEBHeader()->GetNumTXOs());
+        writer.KV("kernel_root", block.mweb_block.GetMWEBHeader()->GetKernelRoot().ToHex());
+        writer.KV("output_root", block.mweb_block.GetMWEBHeader()->GetOutputRoot().ToHex());
+        writer.KV("leaf_root", block.mweb_block.GetMWEBHeader()->GetLeafsetRoot().ToHex());
 
         // MWEB Inputs
-        UniValue inputs(UniValue::VARR);
+        writer.Key("inputs");
+        writer.BeginArray();
         for (const auto& input : block.mweb_block.m_block->GetInputs()) {
             if (txDetails) {
                 UniValue objInput(UniValue::VOBJ);
@@ -242,15 +251,16 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
                 }
 
                 objInput.pushKV("sig", input.GetSignature().ToHex());
-                inputs.push_back(objInput);
+                writer.Value(objInput);
             } else {
-                inputs.push_back(input.GetOutputID().ToHex());
+                writer.Value(input.GetOutputID().ToHex());
             }
         }
-        mweb_block.pushKV("inputs", inputs);
+        writer.EndArray();
 
         // MWEB Outputs
-        UniValue outputs(UniValue::VARR);
+        writer.Key("outputs");
+        writer.BeginArray();
         for (const auto& output : block.mweb_block.m_block->GetOutputs()) {
             if (txDetails) {
                 UniValue objOutput(UniValue::VOBJ);
@@ -260,15 +270,16 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
                 objOutput.pushKV("receiver_pubkey", output.GetReceiverPubKey().ToHex());
                 objOutput.pushKV("range_proof", HexStr(output.GetRangeProof()->Serialized()));
                 objOutput.pushKV("message", HexStr(output.GetOutputMessage().Serialized()));
-                outputs.push_back(objOutput);
+                writer.Value(objOutput);
             } else {
-                outputs.push_back(output.GetOutputID().ToHex());
+                writer.Value(output.GetOutputID().ToHex());
             }
         }
-        mweb_block.pushKV("outputs", outputs);
+        writer.EndArray();
 
         // MWEB Kernels
-        UniValue kernels(UniValue::VARR);
+        writer.Key("kernels");
+        writer.BeginArray();
         for (const auto& kernel : block.mweb_block.m_block->GetKernels()) {
             if (txDetails) {
                 UniValue objKernel(UniValue::VOBJ);
@@ -282,21 +293,28 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
                 if (!kernel.GetExtraData().empty()) {
                     objKernel.pushKV("extra_data", HexStr(kernel.GetExtraData()));
                 }
-                kernels.push_back(objKernel);
+                writer.Value(objKernel);
             } else {
-                kernels.push_back(kernel.GetCommitment().ToHex());
+                writer.Value(kernel.GetCommitment().ToHex());
             }
         }
-        mweb_block.pushKV("kernels", kernels);
+        writer.EndArray();
 
-        result.pushKV("mweb", mweb_block);
+        writer.EndObject();
     }
 
     if (blockindex->pprev)
-        result.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
+        writer.KV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
     if (pnext)
-        result.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
-    return result;
+        writer.KV("nextblockhash", pnext->GetBlockHash().GetHex());
+    writer.EndObject();
+}
+
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
+{
+    UniValueWriter writer;
+    blockToJSON(writer, block, tip, blockindex, txDetails);
+    return std::move(writer.Get());
 }
 
 static RPCHelpMan getblockcount()
@@ -676,24 +694,43 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
 }
 
-UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
+/** Number of verbose mempool entries built per acquisition of the mempool lock */
+static const size_t MEMPOOL_JSON_BATCH_SIZE = 1000;
+
+void MempoolToJSON(JSONWriter& writer, const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
 {
     if (verbose) {
         if (include_mempool_sequence) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Verbose results cannot contain mempool sequence values.");
         }
-        LOCK(pool.cs);
-        UniValue o(UniValue::VOBJ);
-        for (const CTxMemPoolEntry& e : pool.mapTx) {
-            const uint256& hash = e.GetTx().GetHash();
-            UniValue info(UniValue::VOBJ);
-            entryToJSON(pool, info, e);
-            // Mempool has unique entries so there is no advantage in using
-            // UniValue::pushKV, which checks if the key already exists in O(N).
-            // UniValue::__pushKV is used instead which currently is O(1).
-            o.__pushKV(hash.ToString(), info);
+        // The writer may block on a slow client, so pool.cs is never held
+        // while writing. Entries are built in batches under the lock instead,
+        // and transactions that left the pool in the meantime are left out.
+        std::vector<uint256> vtxid;
+        {
+            LOCK(pool.cs);
+            pool.queryHashes(vtxid);
         }
-        return o;
+        writer.BeginObject();
+        std::vector<std::pair<std::string, UniValue>> batch;
+        for (size_t start = 0; start < vtxid.size(); start += MEMPOOL_JSON_BATCH_SIZE) {
+            const size_t end = std::min(start + MEMPOOL_JSON_BATCH_SIZE, vtxid.size());
+            {
+                LOCK(pool.cs);
+                for (size_t i = start; i < end; ++i) {
+                    const auto it = pool.mapTx.find(vtxid[i]);
+                    if (it == pool.mapTx.end()) continue;
+                    UniValue info(UniValue::VOBJ);
+                    entryToJSON(pool, info, *it);
+                    batch.emplace_back(vtxid[i].ToString(), std::move(info));
+                }
+            }
+            for (const auto& entry : batch) {
+                writer.KV(entry.first, entry.second);
+            }
+            batch.clear();
+        }
+        writer.EndObject();
     } else {
         uint64_t mempool_sequence;
         std::vector<uint256> vtxid;
@@ -702,21 +739,28 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempoo
             pool.queryHashes(vtxid);
             mempool_sequence = pool.GetSequence();
         }
-        UniValue a(UniValue::VARR);
+        if (include_mempool_sequence) {
+            writer.BeginObject();
+            writer.Key("txids");
+        }
+        writer.BeginArray();
         for (const uint256& hash : vtxid)
-            a.push_back(hash.ToString());
-
-        if (!include_mempool_sequence) {
-            return a;
-        } else {
-            UniValue o(UniValue::VOBJ);
-            o.pushKV("txids", a);
-            o.pushKV("mempool_sequence", mempool_sequence);
-            return o;
+            writer.Value(hash.ToString());
+        writer.EndArray();
+        if (include_mempool_sequence) {
+            writer.KV("mempool_sequence", mempool_sequence);
+            writer.EndObject();
         }
     }
 }
 
+UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
+{
+    UniValueWriter writer;
+    MempoolToJSON(writer, pool, verbose, include_mempool_sequence);
+    return std::move(writer.Get());
+}
+
 static RPCHelpMan getrawmempool()
 {
     return RPCHelpMan{"getrawmempool",
@@ -762,7 +806,11 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
-    return MempoolToJSON(EnsureMemPool(request.context), fVerbose, include_mempool_sequence);
+    const CTxMemPool& mempool = EnsureMemPool(request.context);
+    if (request.StreamResult([&](JSONWriter& writer) { MempoolToJSON(writer, mempool, fVerbose, include_mempool_sequence); })) {
+        return NullUniValue;
+    }
+    return MempoolToJSON(mempool, fVerbose, include_mempool_sequence);
 },
     };
 }
@@ -1145,6 +1193,9 @@ static RPCHelpMan getblock()
         return strHex;
     }
 
+    if (request.StreamResult([&](JSONWriter& writer) { blockToJSON(writer, block, tip, pblockindex, verbosity >= 2); })) {
+        return NullUniValue;
+    }
     return blockToJSON(block, tip, pblockindex, verbosity >= 2);
 },
     };
@@ -2533,6 +2584,207 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+/** Default and maximum number of entries returned by one address index lookup */
+static const int DEFAULT_ADDRESS_INDEX_PAGE = 1000;
+static const int MAX_ADDRESS_INDEX_PAGE = 10000;
+
+static const std::vector<RPCArg> ADDRESS_INDEX_ARGS{
+    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address, or the hex-encoded scriptPubKey"},
+    {"count", RPCArg::Type::NUM, /* default */ strprintf("%d", DEFAULT_ADDRESS_INDEX_PAGE), strprintf("The maximum number of entries to return (at most %d)", MAX_ADDRESS_INDEX_PAGE)},
+    {"cursor", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "Where to continue, as returned in \"next\" by a previous call"},
+};
+
+/** Parse the arguments of an address index lookup, waiting for the index to catch up with the chain. */
+static AddressIndex& ParseAddressIndexArgs(const JSONRPCRequest& request, uint256& script_hash, size_t& count)
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is not enabled. Use -addressindex");
+    }
+
+    const std::string& address = request.params[0].get_str();
+    CTxDestination dest = DecodeDestination(address);
+    CScript script;
+    if (IsValidDestination(dest)) {
+        if (dest.type() == typeid(StealthAddress)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "MWEB addresses are not indexed");
+        }
+        script = GetScriptForDestination(dest);
+    } else if (IsHex(address)) {
+        std::vector<unsigned char> data(ParseHex(address));
+        script = CScript(data.begin(), data.end());
+    } else {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script: " + address);
+    }
+    script_hash = AddressIndex::HashScript(script);
+
+    int n = request.params[1].isNull() ? DEFAULT_ADDRESS_INDEX_PAGE : request.params[1].get_int();
+    if (n < 1 || n > MAX_ADDRESS_INDEX_PAGE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("count must be between 1 and %d", MAX_ADDRESS_INDEX_PAGE));
+    }
+    count = n;
+
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_IN_WARMUP, "Address index is still being built");
+    }
+    return *g_addressindex;
+}
+
+/** Decode the cursor of a lookup, which is the serialized position of the first entry to return. */
+template <typename T>
+static void ParseAddressIndexCursor(const UniValue& param, T& start)
+{
+    if (param.isNull()) return;
+
+    std::vector<unsigned char> data(ParseHexV(param, "cursor"));
+    CDataStream stream(data, SER_DISK, CLIENT_VERSION);
+    try {
+        stream >> start;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    if (!stream.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+}
+
+template <typename T>
+static std::string AddressIndexCursor(const T& start)
+{
+    CDataStream stream(SER_DISK, CLIENT_VERSION);
+    stream << start;
+    return HexStr(stream);
+}
+
+RPCHelpMan getaddresshistory()
+{
+    return RPCHelpMan{"getaddresshistory",
+                "\nReturns the transactions that created or spent transparent outputs paying to an address, oldest first.\n"
+                "Requires -addressindex. Pages of at most count entries are returned; pass the \"next\" value of a reply as\n"
+                "cursor to get the following page.\n",
+                ADDRESS_INDEX_ARGS,
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::ARR, "history", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                                {RPCResult::Type::NUM, "height", "The height of the block containing the transaction"},
+                                {RPCResult::Type::STR, "type", "\"funding\" if the transaction created the output, \"spending\" if it spent it"},
+                                {RPCResult::Type::NUM, "n", "The index of the output, or of the input spending it"},
+                                {RPCResult::Type::STR_HEX, "prevout_txid", /* optional */ true, "The transaction id of the spent output"},
+                                {RPCResult::Type::NUM, "prevout_n", /* optional */ true, "The index of the spent output"},
+                                {RPCResult::Type::STR_AMOUNT, "amount", "The amount of the output in " + CURRENCY_UNIT},
+                            }},
+                        }},
+                        {RPCResult::Type::STR_HEX, "next", /* optional */ true, "The cursor of the next page, if there are more entries"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\" 100")
+            + HelpExampleRpc("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\", 100")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    uint256 script_hash;
+    size_t count;
+    AddressIndex& index = ParseAddressIndexArgs(request, script_hash, count);
+    AddressHistoryPos start;
+    ParseAddressIndexCursor(request.params[2], start);
+
+    // Read one more entry than returned, to learn where the next page starts.
+    std::vector<AddressHistoryEntry> entries;
+    if (!index.FindHistory(script_hash, start, count + 1, entries)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    UniValue history(UniValue::VARR);
+    for (size_t i = 0; i < entries.size() && i < count; ++i) {
+        const AddressHistoryEntry& entry = entries[i];
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", entry.txid.GetHex());
+        obj.pushKV("height", entry.pos.height);
+        obj.pushKV("type", entry.pos.spend ? "spending" : "funding");
+        obj.pushKV("n", (int64_t)entry.pos.index);
+        if (entry.pos.spend) {
+            obj.pushKV("prevout_txid", entry.outpoint.hash.GetHex());
+            obj.pushKV("prevout_n", (int64_t)entry.outpoint.n);
+        }
+        obj.pushKV("amount", ValueFromAmount(entry.amount));
+        history.push_back(obj);
+    }
+    ret.pushKV("history", history);
+    if (entries.size() > count) {
+        ret.pushKV("next", AddressIndexCursor(entries.back().pos));
+    }
+    return ret;
+},
+    };
+}
+
+RPCHelpMan getaddressutxos()
+{
+    return RPCHelpMan{"getaddressutxos",
+                "\nReturns the unspent transparent outputs paying to an address, without mempool transactions.\n"
+                "Requires -addressindex. Pages of at most count outputs are returned; pass the \"next\" value of a reply as\n"
+                "cursor to get the following page.\n",
+                ADDRESS_INDEX_ARGS,
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::ARR, "utxos", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                                {RPCResult::Type::NUM, "vout", "The output number"},
+                                {RPCResult::Type::NUM, "height", "The height of the block containing the transaction"},
+                                {RPCResult::Type::STR_AMOUNT, "amount", "The amount of the output in " + CURRENCY_UNIT},
+                                {RPCResult::Type::BOOL, "coinbase", "Whether the output was created by a coinbase transaction"},
+                            }},
+                        }},
+                        {RPCResult::Type::STR_HEX, "next", /* optional */ true, "The cursor of the next page, if there are more outputs"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+            + HelpExampleRpc("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    uint256 script_hash;
+    size_t count;
+    AddressIndex& index = ParseAddressIndexArgs(request, script_hash, count);
+    COutPoint start(uint256(), 0);
+    ParseAddressIndexCursor(request.params[2], start);
+
+    // Read one more output than returned, to learn where the next page starts.
+    std::vector<AddressUnspent> unspent;
+    if (!index.FindUnspent(script_hash, start, count + 1, unspent)) {
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    UniValue utxos(UniValue::VARR);
+    for (size_t i = 0; i < unspent.size() && i < count; ++i) {
+        const AddressUnspent& utxo = unspent[i];
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", utxo.outpoint.hash.GetHex());
+        obj.pushKV("vout", (int64_t)utxo.outpoint.n);
+        obj.pushKV("height", utxo.height);
+        obj.pushKV("amount", ValueFromAmount(utxo.amount));
+        obj.pushKV("coinbase", utxo.coinbase);
+        utxos.push_back(obj);
+    }
+    ret.pushKV("utxos", utxos);
+    if (unspent.size() > count) {
+        ret.pushKV("next", AddressIndexCursor(unspent.back().outpoint));
+    }
+    return ret;
+},
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2554,6 +2806,7 @@ static RPCHelpMan dumptxoutset()
             RPCResult::Type::OBJ, "", "",
                 {
                     {RPCResult::Type::NUM, "coins_written", "the number of coins written in the snapshot"},
+                    {RPCResult::Type::NUM, "mweb_coins_written", "the number of MWEB coins written in the snapshot"},
                     {RPCResult::Type::STR_HEX, "base_hash", "the hash of the base of the snapshot"},
                     {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
@@ -2579,6 +2832,7 @@ static RPCHelpMan dumptxoutset()
     FILE* file{fsbridge::fopen(temppath, "wb")};
     CAutoFile afile{file, SER_DISK, CLIENT_VERSION};
     std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<mw::SnapshotWriter> mweb_writer;
     CCoinsStats stats;
     CBlockIndex* tip;
     NodeContext& node = EnsureNodeContext(request.context);
@@ -2607,9 +2861,15 @@ static RPCHelpMan dumptxoutset()
         pcursor = std::unique_ptr<CCoinsViewCursor>(::ChainstateActive().CoinsDB().Cursor());
         tip = LookupBlockIndex(stats.hashBlock);
         CHECK_NONFATAL(tip);
+
+        // MWEB: Like the cursor above, the writer captures a consistent view of the
+        // MWEB UTXO set and MMRs, so it can be written after releasing cs_main.
+        mweb_writer = MakeUnique<mw::SnapshotWriter>(::ChainstateActive().CoinsDB().GetMWEBView());
     }
 
-    SnapshotMetadata metadata{tip->GetBlockHash(), stats.coins_count, tip->nChainTx};
+    const mw::Header::CPtr& mweb_header = mweb_writer->GetHeader();
+    const uint64_t mweb_coins_count = mweb_header ? mweb_writer->GetNumUTXOs() : 0;
+    SnapshotMetadata metadata{tip->GetBlockHash(), stats.coins_count, tip->nChainTx, mweb_header, mweb_coins_count};
 
     afile << metadata;
 
@@ -2628,11 +2888,16 @@ static RPCHelpMan dumptxoutset()
         pcursor->Next();
     }
 
+    if (mweb_header) {
+        mweb_writer->Write(afile, node.rpc_interruption_point);
+    }
+
     afile.fclose();
     fs::rename(temppath, path);
 
     UniValue result(UniValue::VOBJ);
     result.pushKV("coins_written", stats.coins_count);
+    result.pushKV("mweb_coins_written", mweb_coins_count);
     result.pushKV("base_hash", tip->GetBlockHash().ToString());
     result.pushKV("base_height", tip->nHeight);
     result.pushKV("path", path.string());
@@ -2671,6 +2936,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
     { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
+    { "blockchain",         "getaddresshistory",      &getaddresshistory,      {"address", "count", "cursor"} },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"address", "count", "cursor"} },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
@@ -0,0 +1,96 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonwriter.h>
+
+#include <assert.h>
+#include <utility>
+
+void UniValueWriter::Begin(UniValue::VType type)
+{
+    m_open.emplace_back(type);
+    m_open_keys.push_back(std::move(m_key));
+}
+
+void UniValueWriter::End()
+{
+    assert(!m_open.empty());
+    UniValue value = std::move(m_open.back());
+    m_open.pop_back();
+    m_key = std::move(m_open_keys.back());
+    m_open_keys.pop_back();
+    Value(value);
+}
+
+void UniValueWriter::Value(const UniValue& value)
+{
+    if (m_open.empty()) {
+        m_result = value;
+    } else if (m_open.back().isObject()) {
+        // Writers don't repeat keys, so skip the O(N) duplicate check of pushKV.
+        m_open.back().__pushKV(m_key, value);
+    } else {
+        m_open.back().push_back(value);
+    }
+}
+
+JSONStreamWriter::JSONStreamWriter(Sink sink, size_t chunk_size) : m_sink(std::move(sink)), m_chunk_size(chunk_size)
+{
+    m_buffer.reserve(m_chunk_size);
+}
+
+void JSONStreamWriter::Separate()
+{
+    if (m_after_key) {
+        m_after_key = false;
+    } else if (!m_open_empty.empty()) {
+        if (!m_open_empty.back()) m_buffer += ',';
+        m_open_empty.back() = false;
+    }
+}
+
+void JSONStreamWriter::Begin(char open)
+{
+    Separate();
+    m_buffer += open;
+    m_open_empty.push_back(true);
+}
+
+void JSONStreamWriter::End(char close)
+{
+    assert(!m_open_empty.empty() && !m_after_key);
+    m_open_empty.pop_back();
+    m_buffer += close;
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!m_after_key);
+    Separate();
+    m_buffer += UniValue(key).write();
+    m_buffer += ':';
+    m_after_key = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    Separate();
+    m_buffer += value.write();
+    MaybeFlush();
+}
+
+void JSONStreamWriter::MaybeFlush()
+{
+    if (m_buffer.size() >= m_chunk_size) Flush();
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+    std::string chunk;
+    chunk.reserve(m_chunk_size);
+    std::swap(chunk, m_buffer);
+    m_sink(std::move(chunk));
+}
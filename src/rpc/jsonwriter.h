@@ -0,0 +1,107 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONWRITER_H
+#define BITCOIN_RPC_JSONWRITER_H
+
+#include <univalue.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Amount of text buffered by a JSONStreamWriter before it is handed on */
+static const size_t DEFAULT_JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Receives a JSON document piece by piece. Large results are written through
+ * this interface, so that they can either be built as a UniValue or be
+ * serialized while they are produced, without the whole document ever
+ * existing as a tree.
+ */
+class JSONWriter
+{
+public:
+    virtual ~JSONWriter() {}
+
+    virtual void BeginObject() = 0;
+    virtual void EndObject() = 0;
+    virtual void BeginArray() = 0;
+    virtual void EndArray() = 0;
+    /** Name the next value written into the current object. */
+    virtual void Key(const std::string& key) = 0;
+    /** Write a complete value, which may itself be an object or an array. */
+    virtual void Value(const UniValue& value) = 0;
+
+    void KV(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+};
+
+/** Builds the written document as a UniValue. */
+class UniValueWriter : public JSONWriter
+{
+public:
+    void BeginObject() override { Begin(UniValue::VOBJ); }
+    void EndObject() override { End(); }
+    void BeginArray() override { Begin(UniValue::VARR); }
+    void EndArray() override { End(); }
+    void Key(const std::string& key) override { m_key = key; }
+    void Value(const UniValue& value) override;
+
+    /** The written document, once every object and array has been closed. */
+    UniValue& Get() { return m_result; }
+
+private:
+    void Begin(UniValue::VType type);
+    void End();
+
+    //! Objects and arrays that are still open, innermost last
+    std::vector<UniValue> m_open;
+    //! Keys the open objects and arrays will be added under
+    std::vector<std::string> m_open_keys;
+    std::string m_key;
+    UniValue m_result;
+};
+
+/**
+ * Serializes the written document as it is produced, in the same form as
+ * UniValue::write() without indentation. The text is handed to the sink in
+ * chunks of about chunk_size bytes; call Flush() to pass on the remainder.
+ */
+class JSONStreamWriter : public JSONWriter
+{
+public:
+    typedef std::function<void(std::string&& chunk)> Sink;
+
+    explicit JSONStreamWriter(Sink sink, size_t chunk_size = DEFAULT_JSON_STREAM_CHUNK_SIZE);
+
+    void BeginObject() override { Begin('{'); }
+    void EndObject() override { End('}'); }
+    void BeginArray() override { Begin('['); }
+    void EndArray() override { End(']'); }
+    void Key(const std::string& key) override;
+    void Value(const UniValue& value) override;
+
+    void Flush();
+
+private:
+    void Begin(char open);
+    void End(char close);
+    //! Write the separator due before the next element
+    void Separate();
+    void MaybeFlush();
+
+    const Sink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    //! Whether each open object or array has no elements yet, innermost last
+    std::vector<bool> m_open_empty;
+    //! Whether a key was written that still awaits its value
+    bool m_after_key{false};
+};
+
+#endif // BITCOIN_RPC_JSONWRITER_H
@@ -139,6 +139,8 @@ static RPCHelpMan getpeerinfo()
                             {
                                 {RPCResult::Type::NUM, "n", "The heights of blocks we're currently asking from this peer"},
                             }},
+                            {RPCResult::Type::NUM, "inflight_limit", "The number of blocks we may ask from this peer at once, sized from its download speed"},
+                            {RPCResult::Type::NUM, "block_download_rate", "The speed (in bytes per second) at which this peer has delivered the blocks we asked for, or 0 if not measured yet"},
                             {RPCResult::Type::NUM, "addr_processed", "The total number of addresses processed, excluding those dropped due to rate limiting"},
                             {RPCResult::Type::NUM, "addr_rate_limited", "The total number of addresses dropped due to rate limiting"},
                             {RPCResult::Type::BOOL, "whitelisted", /* optional */ true, "Whether the peer is whitelisted with default permissions\n"
@@ -238,6 +240,8 @@ static RPCHelpMan getpeerinfo()
                 heights.push_back(height);
             }
             obj.pushKV("inflight", heights);
+            obj.pushKV("inflight_limit", statestats.m_blocks_in_flight_limit);
+            obj.pushKV("block_download_rate", statestats.m_block_download_rate);
             obj.pushKV("addr_processed", statestats.m_addr_processed);
             obj.pushKV("addr_rate_limited", statestats.m_addr_rate_limited);
         }
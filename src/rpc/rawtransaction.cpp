@@ -10,6 +10,8 @@
 #include <index/txindex.h>
 #include <key_io.h>
 #include <merkleblock.h>
+#include <mweb/mweb_node.h>
+#include <mweb/mweb_proof.h>
 #include <node/coin.h>
 #include <node/context.h>
 #include <node/psbt.h>
@@ -368,6 +370,115 @@ static RPCHelpMan verifytxoutproof()
     };
 }
 
+static mw::Hash ParseOutputID(const UniValue& v)
+{
+    const std::string& strHex(v.get_str());
+    if (64 != strHex.length())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("output_id must be of length %d (not %d, for '%s')", 64, strHex.length(), strHex));
+    if (!IsHex(strHex))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "output_id must be hexadecimal string (not '" + strHex + "')");
+    return mw::Hash::FromHex(strHex);
+}
+
+static RPCHelpMan getmwebutxoproof()
+{
+    return RPCHelpMan{"getmwebutxoproof",
+                "\nReturns a hex-encoded proof that the MWEB outputs are included in the output MMR of the current tip.\n"
+                "\nThe outputs must be unspent. Proving multiple outputs at once is much smaller and faster than proving\n"
+                "them individually, since the hashes their MMR paths have in common are only included once.\n"
+                "At most -maxmwebutxoproofoutputs (default: " + ToString(MWEB::DEFAULT_MAX_UTXO_PROOF_OUTPUTS) + ") outputs can be proven at once.\n",
+                {
+                    {"output_ids", RPCArg::Type::ARR, RPCArg::Optional::NO, "The MWEB output IDs to prove",
+                        {
+                            {"output_id", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "An MWEB output ID"},
+                        },
+                        },
+                },
+                RPCResult{
+                    RPCResult::Type::STR, "data", "A string that is a serialized, hex-encoded data for the proof."
+                },
+                RPCExamples{
+                    HelpExampleCli("getmwebutxoproof", "'[\"output_id\",...]'")
+            + HelpExampleRpc("getmwebutxoproof", "[\"output_id\",...]")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::set<mw::Hash> output_ids;
+    const UniValue& params = request.params[0].get_array();
+    const size_t max_outputs = MWEB::Node::MaxUTXOProofOutputs();
+    if (params.size() > max_outputs) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid parameter, max output_ids exceeded (max: %d, tried: %d)", max_outputs, params.size()));
+    }
+    for (unsigned int idx = 0; idx < params.size(); idx++) {
+        mw::Hash output_id = ParseOutputID(params[idx]);
+        if (!output_ids.insert(output_id).second) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, std::string("Invalid parameter, duplicated output_id: ") + params[idx].get_str());
+        }
+    }
+
+    if (output_ids.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, no output_ids given");
+    }
+
+    MWEB::UTXOProof proof;
+    {
+        LOCK(cs_main);
+        std::string error;
+        if (!MWEB::Node::BuildUTXOProof(::ChainstateActive(), {output_ids.begin(), output_ids.end()}, proof, error)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, error);
+        }
+    }
+
+    CDataStream ssProof(SER_NETWORK, PROTOCOL_VERSION);
+    ssProof << proof;
+    return HexStr(ssProof);
+},
+    };
+}
+
+static RPCHelpMan verifymwebutxoproof()
+{
+    return RPCHelpMan{"verifymwebutxoproof",
+                "\nVerifies that a proof points to MWEB outputs in the output MMR of a block, returning the output IDs it commits to\n"
+                "and throwing an RPC error if the block is not in our best chain\n",
+                {
+                    {"proof", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The hex-encoded proof generated by getmwebutxoproof"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "output_id", "The output ID(s) which the proof commits to, or empty array if the proof can not be validated."},
+                    }
+                },
+                RPCExamples{""},
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    CDataStream ssProof(ParseHexV(request.params[0], "proof"), SER_NETWORK, PROTOCOL_VERSION);
+    MWEB::UTXOProof proof;
+    ssProof >> proof;
+
+    UniValue res(UniValue::VARR);
+
+    LOCK(cs_main);
+
+    const CBlockIndex* pindex = LookupBlockIndex(proof.block_hash);
+    const mw::Header::CPtr mweb_header = pindex ? GetMWEBHeader(pindex) : nullptr;
+    if (!pindex || !::ChainActive().Contains(pindex) || mweb_header == nullptr) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found in chain");
+    }
+
+    // Check if proof is valid, only add results if so
+    if (proof.Verify(*mweb_header)) {
+        for (const mw::Hash& output_id : proof.output_ids) {
+            res.push_back(output_id.ToHex());
+        }
+    }
+
+    return res;
+},
+    };
+}
+
 static RPCHelpMan createrawtransaction()
 {
     return RPCHelpMan{"createrawtransaction",
@@ -1880,6 +1991,8 @@ static const CRPCCommand commands[] =
 
     { "blockchain",         "gettxoutproof",                &gettxoutproof,             {"txids", "blockhash"} },
     { "blockchain",         "verifytxoutproof",             &verifytxoutproof,          {"proof"} },
+    { "blockchain",         "getmwebutxoproof",             &getmwebutxoproof,          {"output_ids"} },
+    { "blockchain",         "verifymwebutxoproof",          &verifymwebutxoproof,       {"proof"} },
 };
 // clang-format on
     for (const auto& c : commands) {
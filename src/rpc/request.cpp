@@ -182,3 +182,10 @@ void JSONRPCRequest::parse(const UniValue& valRequest)
     else
         throw JSONRPCError(RPC_INVALID_REQUEST, "Params must be an array or object");
 }
+
+bool JSONRPCRequest::StreamResult(const std::function<void(JSONWriter&)>& write_result) const
+{
+    if (!resultStream) return false;
+    resultStream(write_result);
+    return true;
+}
@@ -6,10 +6,13 @@
 #ifndef BITCOIN_RPC_REQUEST_H
 #define BITCOIN_RPC_REQUEST_H
 
+#include <functional>
 #include <string>
 
 #include <univalue.h>
 
+class JSONWriter;
+
 namespace util {
 class Ref;
 } // namespace util
@@ -39,6 +42,10 @@ public:
     std::string authUser;
     std::string peerAddr;
     const util::Ref& context;
+    //! Set by transports that can send a result while it is being produced,
+    //! see StreamResult. Requests made from this one with another context
+    //! leave it out, as it answers this request only.
+    std::function<void(const std::function<void(JSONWriter&)>&)> resultStream;
 
     JSONRPCRequest(const util::Ref& context) : id(NullUniValue), params(NullUniValue), fHelp(false), context(context) {}
 
@@ -52,6 +59,14 @@ public:
     }
 
     void parse(const UniValue& valRequest);
+
+    /**
+     * Send the result through the transport while write_result produces it,
+     * if the transport supports that. Methods with very large results use this
+     * to avoid building them in memory, and return NullUniValue when it
+     * returns true. When it returns false, they return their result as usual.
+     */
+    bool StreamResult(const std::function<void(JSONWriter&)>& write_result) const;
 };
 
 #endif // BITCOIN_RPC_REQUEST_H
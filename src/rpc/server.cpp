@@ -373,12 +373,26 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCBatchRunner& runner, std::chrono::seconds timeout)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::vector<UniValue> replies(vReq.size());
+    auto exec = [&](size_t reqIdx) {
+        if (timeout.count() > 0 && std::chrono::steady_clock::now() > deadline) {
+            replies[reqIdx] = JSONRPCReplyObj(NullUniValue, JSONRPCError(RPC_MISC_ERROR, "Batch request time limit exceeded"), find_value(vReq[reqIdx], "id"));
+        } else {
+            replies[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+        }
+    };
+    if (runner) {
+        runner(vReq.size(), exec);
+    } else {
+        for (size_t reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            exec(reqIdx);
+    }
 
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(replies);
     return ret.write() + "\n";
 }
 
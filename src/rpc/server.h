@@ -10,6 +10,7 @@
 #include <rpc/request.h>
 #include <rpc/util.h>
 
+#include <chrono>
 #include <functional>
 #include <map>
 #include <stdint.h>
@@ -180,7 +181,14 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+
+/** Runs fn(i) for every i below count, possibly concurrently, and returns once all have returned */
+typedef std::function<void(size_t count, const std::function<void(size_t)>& fn)> RPCBatchRunner;
+
+/** Execute the calls of a batch request, using runner if given, and return the replies in order.
+ * Calls that haven't started within timeout (if non-zero) fail instead.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCBatchRunner& runner = nullptr, std::chrono::seconds timeout = std::chrono::seconds{0});
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
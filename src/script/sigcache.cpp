@@ -23,6 +23,7 @@ class CSignatureCache
 {
 private:
      //! Entries are SHA256(nonce || 'E' or 'S' || 31 zero bytes || signature hash || public key || signature):
+    uint256 m_nonce;
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
@@ -32,19 +33,29 @@ private:
 public:
     CSignatureCache()
     {
-        uint256 nonce = GetRandHash();
+        SetNonce(GetRandHash());
+    }
+
+    //! The entries depend on the nonce, so it must only be changed while the cache is empty.
+    void SetNonce(const uint256& nonce)
+    {
+        m_nonce = nonce;
         // We want the nonce to be 64 bytes long to force the hasher to process
         // this chunk, which makes later hash computations more efficient. We
         // just write our 32-byte entropy, and then pad with 'E' for ECDSA and
         // 'S' for Schnorr (followed by 0 bytes).
         static constexpr unsigned char PADDING_ECDSA[32] = {'E'};
         static constexpr unsigned char PADDING_SCHNORR[32] = {'S'};
+        m_salted_hasher_ecdsa = CSHA256();
         m_salted_hasher_ecdsa.Write(nonce.begin(), 32);
         m_salted_hasher_ecdsa.Write(PADDING_ECDSA, 32);
+        m_salted_hasher_schnorr = CSHA256();
         m_salted_hasher_schnorr.Write(nonce.begin(), 32);
         m_salted_hasher_schnorr.Write(PADDING_SCHNORR, 32);
     }
 
+    const uint256& GetNonce() const { return m_nonce; }
+
     void
     ComputeEntryECDSA(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const
     {
@@ -71,6 +82,15 @@ public:
         boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
         setValid.insert(entry);
     }
+
+    std::vector<uint256> GetEntries()
+    {
+        std::vector<uint256> entries;
+        // Inserting takes an exclusive lock, so a shared one keeps the table still.
+        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+        setValid.for_each([&](const uint256& entry) { entries.push_back(entry); });
+        return entries;
+    }
     uint32_t setup_bytes(size_t n)
     {
         return setValid.setup_bytes(n);
@@ -98,6 +118,20 @@ void InitSignatureCache()
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+void DumpSignatureCache(uint256& nonce, std::vector<uint256>& entries)
+{
+    nonce = signatureCache.GetNonce();
+    entries = signatureCache.GetEntries();
+}
+
+void LoadSignatureCache(const uint256& nonce, const std::vector<uint256>& entries)
+{
+    signatureCache.SetNonce(nonce);
+    for (uint256 entry : entries) {
+        signatureCache.Set(entry);
+    }
+}
+
 bool CachingTransactionSignatureChecker::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
@@ -55,4 +55,13 @@ public:
 
 void InitSignatureCache();
 
+/** Returns the signature cache's salt and entries, to persist them across restarts. */
+void DumpSignatureCache(uint256& nonce, std::vector<uint256>& entries);
+
+/**
+ * Restores the signature cache returned by DumpSignatureCache. This replaces
+ * the salt, so it must be called before the cache is used.
+ */
+void LoadSignatureCache(const uint256& nonce, const std::vector<uint256>& entries);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -0,0 +1,177 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, BasicTestingSetup)
+
+static CTransactionRef MakeCoinbase(int height, const std::vector<CTxOut>& outputs)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << height << OP_0;
+    tx.vout = outputs;
+    return MakeTransactionRef(tx);
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_lookups)
+{
+    AddressIndex index(1 << 20, true);
+
+    const CScript script_a = CScript() << OP_1;
+    const CScript script_b = CScript() << OP_2;
+    const CScript script_null = CScript() << OP_RETURN << OP_3;
+    const uint256 hash_a = AddressIndex::HashScript(script_a);
+    const uint256 hash_b = AddressIndex::HashScript(script_b);
+
+    // Block 1 pays to both scripts, and carries an unspendable output.
+    CBlock block1;
+    block1.vtx.push_back(MakeCoinbase(1, {CTxOut(50 * COIN, script_a), CTxOut(10 * COIN, script_b), CTxOut(0, script_null)}));
+    CBlockUndo undo1;
+    BOOST_CHECK(index.IndexBlock(block1, undo1, 1));
+
+    // Block 2 spends the output paying to script_a, with change back to it.
+    CMutableTransaction spend;
+    spend.vin.emplace_back(COutPoint(block1.vtx[0]->GetHash(), 0));
+    spend.vout.emplace_back(30 * COIN, script_b);
+    spend.vout.emplace_back(19 * COIN, script_a);
+    CBlock block2;
+    block2.vtx.push_back(MakeCoinbase(2, {CTxOut(50 * COIN, script_b)}));
+    block2.vtx.push_back(MakeTransactionRef(spend));
+    CBlockUndo undo2;
+    undo2.vtxundo.emplace_back();
+    undo2.vtxundo[0].vprevout.emplace_back(CTxOut(50 * COIN, script_a), 1, true, false);
+
+    // Undo data that does not match the block is rejected.
+    BOOST_CHECK(!index.IndexBlock(block2, undo1, 2));
+    BOOST_CHECK(index.IndexBlock(block2, undo2, 2));
+
+    const uint256 spend_txid = block2.vtx[1]->GetHash();
+    std::vector<AddressHistoryEntry> history;
+    BOOST_CHECK(index.FindHistory(hash_a, AddressHistoryPos(), 10, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 3U);
+    BOOST_CHECK(!history[0].pos.spend);
+    BOOST_CHECK_EQUAL(history[0].pos.height, 1);
+    BOOST_CHECK(history[0].outpoint == COutPoint(block1.vtx[0]->GetHash(), 0));
+    BOOST_CHECK_EQUAL(history[0].amount, 50 * COIN);
+    // The spend is ordered ahead of the change output of the same transaction.
+    BOOST_CHECK(history[1].pos.spend);
+    BOOST_CHECK_EQUAL(history[1].pos.height, 2);
+    BOOST_CHECK_EQUAL(history[1].pos.tx_pos, 1U);
+    BOOST_CHECK(history[1].txid == spend_txid);
+    BOOST_CHECK(history[1].outpoint == history[0].outpoint);
+    BOOST_CHECK(!history[2].pos.spend);
+    BOOST_CHECK(history[2].outpoint == COutPoint(spend_txid, 1));
+    BOOST_CHECK_EQUAL(history[2].amount, 19 * COIN);
+
+    // Pages continue from the position of their first entry.
+    std::vector<AddressHistoryEntry> page;
+    BOOST_CHECK(index.FindHistory(hash_a, AddressHistoryPos(), 2, page));
+    BOOST_CHECK_EQUAL(page.size(), 2U);
+    BOOST_CHECK(index.FindHistory(hash_a, history[2].pos, 2, page));
+    BOOST_REQUIRE_EQUAL(page.size(), 1U);
+    BOOST_CHECK(page[0].txid == spend_txid);
+
+    BOOST_CHECK(index.FindHistory(hash_b, AddressHistoryPos(), 10, history));
+    BOOST_CHECK_EQUAL(history.size(), 3U);
+    BOOST_CHECK(index.FindHistory(AddressIndex::HashScript(script_null), AddressHistoryPos(), 10, history));
+    BOOST_CHECK(history.empty());
+
+    std::vector<AddressUnspent> unspent;
+    BOOST_CHECK(index.FindUnspent(hash_a, COutPoint(uint256(), 0), 10, unspent));
+    BOOST_REQUIRE_EQUAL(unspent.size(), 1U);
+    BOOST_CHECK(unspent[0].outpoint == COutPoint(spend_txid, 1));
+    BOOST_CHECK_EQUAL(unspent[0].height, 2);
+    BOOST_CHECK(!unspent[0].coinbase);
+
+    BOOST_CHECK(index.FindUnspent(hash_b, COutPoint(uint256(), 0), 10, unspent));
+    BOOST_REQUIRE_EQUAL(unspent.size(), 3U);
+    std::vector<AddressUnspent> unspent_page;
+    BOOST_CHECK(index.FindUnspent(hash_b, unspent[1].outpoint, 10, unspent_page));
+    BOOST_REQUIRE_EQUAL(unspent_page.size(), 2U);
+    BOOST_CHECK(unspent_page[0].outpoint == unspent[1].outpoint);
+    BOOST_CHECK(unspent_page[1].outpoint == unspent[2].outpoint);
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_unindex)
+{
+    AddressIndex index(1 << 20, true);
+
+    const CScript script_a = CScript() << OP_1;
+    const CScript script_b = CScript() << OP_2;
+    const CScript script_c = CScript() << OP_3;
+    const CScript script_d = CScript() << OP_4;
+    const uint256 hash_a = AddressIndex::HashScript(script_a);
+    const uint256 hash_b = AddressIndex::HashScript(script_b);
+    const uint256 hash_c = AddressIndex::HashScript(script_c);
+    const uint256 hash_d = AddressIndex::HashScript(script_d);
+
+    CBlock block1;
+    block1.vtx.push_back(MakeCoinbase(1, {CTxOut(50 * COIN, script_a), CTxOut(10 * COIN, script_b)}));
+    BOOST_CHECK(index.IndexBlock(block1, CBlockUndo(), 1));
+
+    // Block 2 spends the output paying to script_a, and the output it pays to
+    // script_d is spent again in the same block.
+    CMutableTransaction spend1;
+    spend1.vin.emplace_back(COutPoint(block1.vtx[0]->GetHash(), 0));
+    spend1.vout.emplace_back(49 * COIN, script_d);
+    CMutableTransaction spend2;
+    spend2.vin.emplace_back(COutPoint(spend1.GetHash(), 0));
+    spend2.vout.emplace_back(48 * COIN, script_b);
+    CBlock block2;
+    block2.vtx.push_back(MakeCoinbase(2, {CTxOut(50 * COIN, script_c)}));
+    block2.vtx.push_back(MakeTransactionRef(spend1));
+    block2.vtx.push_back(MakeTransactionRef(spend2));
+    CBlockUndo undo2;
+    undo2.vtxundo.resize(2);
+    undo2.vtxundo[0].vprevout.emplace_back(CTxOut(50 * COIN, script_a), 1, true, false);
+    undo2.vtxundo[1].vprevout.emplace_back(CTxOut(49 * COIN, script_d), 2, false, false);
+    BOOST_CHECK(index.IndexBlock(block2, undo2, 2));
+
+    std::vector<AddressHistoryEntry> history;
+    std::vector<AddressUnspent> unspent;
+    BOOST_CHECK(index.FindHistory(hash_d, AddressHistoryPos(), 10, history));
+    BOOST_CHECK_EQUAL(history.size(), 2U);
+    BOOST_CHECK(index.FindUnspent(hash_d, COutPoint(uint256(), 0), 10, unspent));
+    BOOST_CHECK(unspent.empty());
+    BOOST_CHECK(index.FindUnspent(hash_b, COutPoint(uint256(), 0), 10, unspent));
+    BOOST_CHECK_EQUAL(unspent.size(), 2U);
+
+    // Undo data that does not match the block is rejected.
+    BOOST_CHECK(!index.UnindexBlock(block2, CBlockUndo(), 2));
+    BOOST_CHECK(index.UnindexBlock(block2, undo2, 2));
+
+    // Only the entries of block 1 are left.
+    for (const uint256& hash : {hash_c, hash_d}) {
+        BOOST_CHECK(index.FindHistory(hash, AddressHistoryPos(), 10, history));
+        BOOST_CHECK(history.empty());
+        BOOST_CHECK(index.FindUnspent(hash, COutPoint(uint256(), 0), 10, unspent));
+        BOOST_CHECK(unspent.empty());
+    }
+    BOOST_CHECK(index.FindHistory(hash_a, AddressHistoryPos(), 10, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 1U);
+    BOOST_CHECK(!history[0].pos.spend);
+    BOOST_CHECK_EQUAL(history[0].pos.height, 1);
+    BOOST_CHECK(index.FindHistory(hash_b, AddressHistoryPos(), 10, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 1U);
+    BOOST_CHECK_EQUAL(history[0].pos.height, 1);
+
+    // The output spent by block 2 is unspent again, as it was before.
+    BOOST_CHECK(index.FindUnspent(hash_a, COutPoint(uint256(), 0), 10, unspent));
+    BOOST_REQUIRE_EQUAL(unspent.size(), 1U);
+    BOOST_CHECK(unspent[0].outpoint == COutPoint(block1.vtx[0]->GetHash(), 0));
+    BOOST_CHECK_EQUAL(unspent[0].height, 1);
+    BOOST_CHECK_EQUAL(unspent[0].amount, 50 * COIN);
+    BOOST_CHECK(unspent[0].coinbase);
+    BOOST_CHECK(index.FindUnspent(hash_b, COutPoint(uint256(), 0), 10, unspent));
+    BOOST_REQUIRE_EQUAL(unspent.size(), 1U);
+    BOOST_CHECK(unspent[0].outpoint == COutPoint(block1.vtx[0]->GetHash(), 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
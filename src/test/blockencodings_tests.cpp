@@ -8,6 +8,13 @@
 #include <pow.h>
 #include <streams.h>
 
+#include <mw/consensus/Aggregation.h>
+#include <mw/mmr/MMR.h>
+#include <mw/node/CoinsView.h>
+#include <mweb/mweb_db.h>
+#include <test_framework/Miner.h>
+#include <test_framework/TxBuilder.h>
+
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -72,7 +79,7 @@ BOOST_AUTO_TEST_CASE(SimpleRoundTripTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK( partialBlock.IsTxAvailable(0));
         BOOST_CHECK(!partialBlock.IsTxAvailable(1));
@@ -162,7 +169,7 @@ BOOST_AUTO_TEST_CASE(NonCoinbasePreforwardRTTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK(!partialBlock.IsTxAvailable(0));
         BOOST_CHECK( partialBlock.IsTxAvailable(1));
@@ -232,7 +239,7 @@ BOOST_AUTO_TEST_CASE(SufficientPreforwardRTTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK( partialBlock.IsTxAvailable(0));
         BOOST_CHECK( partialBlock.IsTxAvailable(1));
@@ -287,7 +294,7 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK(partialBlock.IsTxAvailable(0));
 
@@ -300,6 +307,170 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+static CBlock BuildMWEBBlockTestCase(const mw::Block::CPtr& mweb_block);
+
+static CBlock BuildMWEBBlockTestCase(const std::vector<mw::Transaction::CPtr>& mweb_txs) {
+    mw::Transaction::CPtr pAggregated = Aggregation::Aggregate(mweb_txs);
+
+    MemMMR kernel_mmr;
+    for (const Kernel& kernel : pAggregated->GetKernels()) {
+        kernel_mmr.Add(kernel);
+    }
+
+    mw::Header::CPtr pHeader = std::make_shared<mw::Header>(
+        1,
+        mw::Hash(InsecureRand256().begin()),
+        kernel_mmr.Root(),
+        mw::Hash(InsecureRand256().begin()),
+        BlindingFactor(pAggregated->GetKernelOffset()),
+        BlindingFactor(pAggregated->GetStealthOffset()),
+        pAggregated->GetOutputs().size(),
+        pAggregated->GetKernels().size()
+    );
+
+    return BuildMWEBBlockTestCase(std::make_shared<mw::Block>(pHeader, pAggregated->GetBody()));
+}
+
+static CBlock BuildMWEBBlockTestCase(const mw::Block::CPtr& mweb_block) {
+    CBlock block;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig.resize(10);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 42;
+
+    block.vtx.resize(2);
+    block.vtx[0] = MakeTransactionRef(tx);
+
+    tx.vin[0].prevout.hash = InsecureRand256();
+    tx.vin[0].prevout.n = 0;
+    tx.m_hogEx = true;
+    block.vtx[1] = MakeTransactionRef(tx);
+
+    block.mweb_block = MWEB::Block(mweb_block);
+    block.nVersion = 1;
+    block.hashPrevBlock = InsecureRand256();
+    block.nBits = 0x207fffff;
+
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    assert(!mutated);
+    while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, Params().GetConsensus())) ++block.nNonce;
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(CompactMWEBBlockTest)
+{
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+
+    // Only the first MWEB transaction is in the mempool
+    test::Tx mweb_tx1 = test::TxBuilder().AddInput(20).AddOutput(15).AddPlainKernel(5, true).Build();
+    test::Tx mweb_tx2 = test::TxBuilder().AddPeginKernel(10).AddOutput(10).Build();
+    CBlock block(BuildMWEBBlockTestCase({mweb_tx1.GetTransaction(), mweb_tx2.GetTransaction()}));
+
+    CMutableTransaction mtx;
+    mtx.mweb_tx = MWEB::Tx(mweb_tx1.GetTransaction());
+
+    LOCK2(cs_main, pool.cs);
+    pool.addUnchecked(entry.FromTx(mtx));
+
+    CBlockHeaderAndShortTxIDs shortIDs(block, true);
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_MWEB_COMPACT);
+    stream << shortIDs;
+    BOOST_CHECK(stream.size() * 4 < GetSerializeSize(shortIDs, PROTOCOL_VERSION));
+
+    CBlockHeaderAndShortTxIDs shortIDs2;
+    stream >> shortIDs2;
+    BOOST_CHECK(shortIDs2.mweb_block.IsNull());
+
+    PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
+    BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(0));
+    BOOST_CHECK(partialBlock.IsTxAvailable(1));
+
+    // Only the components of the second transaction should be requested
+    BlockTransactionsRequest req;
+    req.blockhash = block.GetHash();
+    partialBlock.GetMissingMWEBIndexes(req);
+    BOOST_CHECK(req.indexes.empty());
+    BOOST_CHECK(req.mweb_input_indexes.empty());
+    BOOST_CHECK_EQUAL(req.mweb_output_indexes.size(), 1U);
+    BOOST_CHECK_EQUAL(req.mweb_kernel_indexes.size(), 1U);
+
+    CDataStream req_stream(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_MWEB_COMPACT);
+    req_stream << req;
+    BlockTransactionsRequest req2;
+    req_stream >> req2;
+    BOOST_CHECK(req2.mweb_output_indexes == req.mweb_output_indexes);
+    BOOST_CHECK(req2.mweb_kernel_indexes == req.mweb_kernel_indexes);
+
+    BlockTransactions resp(req2);
+    resp.mweb_outputs[0] = block.mweb_block.m_block->GetOutputs()[req2.mweb_output_indexes[0]];
+    resp.mweb_kernels[0] = block.mweb_block.m_block->GetKernels()[req2.mweb_kernel_indexes[0]];
+
+    CDataStream resp_stream(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_MWEB_COMPACT);
+    resp_stream << resp;
+    BlockTransactions resp2;
+    resp_stream >> resp2;
+    BOOST_CHECK(resp2.mweb_outputs == resp.mweb_outputs);
+    BOOST_CHECK(resp2.mweb_kernels == resp.mweb_kernels);
+
+    CBlock block2;
+    {
+        PartiallyDownloadedBlock tmp = partialBlock;
+        BOOST_CHECK(partialBlock.FillBlock(block2, {}) == READ_STATUS_INVALID); // No MWEB components
+        partialBlock = tmp;
+    }
+
+    // Wrong output
+    {
+        PartiallyDownloadedBlock tmp = partialBlock;
+        BOOST_CHECK(partialBlock.FillBlock(block2, {}, {}, mweb_tx1.GetTransaction()->GetOutputs(), resp2.mweb_kernels) == READ_STATUS_FAILED);
+        partialBlock = tmp;
+    }
+
+    CBlock block3;
+    BOOST_CHECK(partialBlock.FillBlock(block3, {}, resp2.mweb_inputs, resp2.mweb_outputs, resp2.mweb_kernels) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(block.GetHash().ToString(), block3.GetHash().ToString());
+    BOOST_CHECK(block3.mweb_block.GetHash() == block.mweb_block.GetHash());
+    BOOST_CHECK(block3.mweb_block.m_block->GetTxBody() == block.mweb_block.m_block->GetTxBody());
+}
+
+BOOST_AUTO_TEST_CASE(CompactMWEBBlockViewTest)
+{
+    CTxMemPool pool;
+    CDBWrapper db(GetDataDir() / "mweb", 1 << 15);
+    auto pDBView = mw::CoinsViewDB::Open(GetDataDir(), nullptr, std::make_shared<MWEB::DBWrapper>(&db));
+    BOOST_REQUIRE(pDBView != nullptr);
+
+    test::Miner miner(GetDataDir());
+    test::Tx mweb_tx = test::Tx::CreatePegIn(1000);
+    CBlock block(BuildMWEBBlockTestCase(miner.MineBlock(1, {mweb_tx}).GetBlock()));
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_MWEB_COMPACT);
+    stream << CBlockHeaderAndShortTxIDs(block, true);
+    CBlockHeaderAndShortTxIDs shortIDs;
+    stream >> shortIDs;
+
+    // The block's outputs, kernels and stealth offset match its header either way, but its output
+    // MMR only follows from the empty one.
+    auto pAppliedView = std::make_shared<mw::CoinsViewCache>(pDBView);
+    pAppliedView->ApplyBlock(block.mweb_block.m_block);
+
+    const TxBody& body = block.mweb_block.m_block->GetTxBody();
+    for (const mw::ICoinsView::Ptr& view : std::vector<mw::ICoinsView::Ptr>{nullptr, pDBView, pAppliedView}) {
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
+        BOOST_CHECK(partialBlock.InitData(shortIDs, extra_txn) == READ_STATUS_OK);
+        partialBlock.SetMWEBView(view);
+
+        CBlock block2;
+        const ReadStatus status = partialBlock.FillBlock(block2, {}, body.GetInputs(), body.GetOutputs(), body.GetKernels());
+        BOOST_CHECK(status == (view == pAppliedView ? READ_STATUS_FAILED : READ_STATUS_OK));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
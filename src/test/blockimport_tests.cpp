@@ -0,0 +1,121 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockimport.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <consensus/consensus.h>
+#include <crypto/common.h>
+#include <streams.h>
+#include <util/lz4.h>
+#include <version.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockimport_tests, BasicTestingSetup)
+
+static CBlock BuildBlock(uint32_t nonce)
+{
+    CBlock block;
+    block.nVersion = 1;
+    block.hashPrevBlock = InsecureRand256();
+    block.nNonce = nonce;
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << (int64_t)nonce;
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 42;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    return block;
+}
+
+static std::vector<uint8_t> SerializeBlock(const CBlock& block)
+{
+    CDataStream stream(SER_DISK, CLIENT_VERSION);
+    stream << block;
+    return std::vector<uint8_t>(stream.begin(), stream.end());
+}
+
+static void WriteRecord(CAutoFile& file, Span<const uint8_t> data, bool compressed = false)
+{
+    CMessageHeader::MessageStartChars record_start;
+    memcpy(record_start, Params().MessageStart(), CMessageHeader::MESSAGE_START_SIZE);
+    if (compressed) {
+        record_start[3] = ~record_start[3];
+    }
+    file << record_start << (unsigned int)data.size();
+    file.write((const char*)data.data(), data.size());
+}
+
+BOOST_AUTO_TEST_CASE(import_records_in_order)
+{
+    std::vector<CBlock> blocks;
+    for (uint32_t i = 0; i < 6; ++i) {
+        blocks.push_back(BuildBlock(i));
+    }
+
+    CAutoFile file(tmpfile(), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    const std::vector<uint8_t> junk(100, 0);
+    file.write((const char*)junk.data(), junk.size());
+
+    // A plain record
+    WriteRecord(file, SerializeBlock(blocks[0]));
+
+    // A compressed record
+    const std::vector<uint8_t> data = SerializeBlock(blocks[1]);
+    std::vector<uint8_t> frame(4);
+    WriteLE32(frame.data(), data.size());
+    const std::vector<uint8_t> compressed = CompressLZ4(data);
+    frame.insert(frame.end(), compressed.begin(), compressed.end());
+    WriteRecord(file, frame, /* compressed */ true);
+
+    // A corrupt record, which another record was written over
+    CDataStream overwritten(SER_DISK, CLIENT_VERSION);
+    // A header followed by a transaction count that is too large
+    const std::vector<uint8_t> garbage(89, 0xff);
+    overwritten.write((const char*)garbage.data(), garbage.size());
+    overwritten << Params().MessageStart() << (unsigned int)SerializeBlock(blocks[2]).size() << blocks[2];
+    WriteRecord(file, MakeUCharSpan(overwritten));
+
+    // A record longer than its block, with another record in the rest of it
+    CDataStream longer(SER_DISK, CLIENT_VERSION);
+    longer << blocks[3] << Params().MessageStart() << (unsigned int)SerializeBlock(blocks[4]).size() << blocks[4];
+    WriteRecord(file, MakeUCharSpan(longer));
+
+    WriteRecord(file, SerializeBlock(blocks[5]));
+
+    // Truncated record at the end of the file
+    const std::vector<uint8_t> truncated = SerializeBlock(blocks[0]);
+    file << Params().MessageStart() << (unsigned int)truncated.size();
+    file.write((const char*)truncated.data(), truncated.size() / 2);
+
+    rewind(file.Get());
+    CBufferedFile blkdat(file.release(), MAX_BLOCK_IMPORT_QUEUE + 2 * MAX_BLOCK_SERIALIZED_SIZE_WITH_MWEB, MAX_BLOCK_IMPORT_QUEUE + MAX_BLOCK_SERIALIZED_SIZE_WITH_MWEB + 8, SER_DISK, CLIENT_VERSION);
+    BlockFileImporter importer(blkdat, 0, Params(), 2);
+
+    std::vector<uint256> hashes;
+    int errors = 0;
+    BlockFileImporter::Record record;
+    while (importer.Next(record)) {
+        if (!record.block) {
+            ++errors;
+            continue;
+        }
+        BOOST_CHECK(record.hash == record.block->GetHash());
+        hashes.push_back(record.hash);
+    }
+    BOOST_CHECK(importer.GetReadError().empty());
+
+    BOOST_CHECK_EQUAL(errors, 2);
+    BOOST_REQUIRE_EQUAL(hashes.size(), blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        BOOST_CHECK(hashes[i] == blocks[i].GetHash());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
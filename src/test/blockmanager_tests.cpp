@@ -0,0 +1,93 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockmanager_tests, BasicTestingSetup)
+
+static mw::Header::CPtr BuildMWEBHeader(int32_t height)
+{
+    return std::make_shared<mw::Header>(
+        height,
+        mw::Hash(InsecureRand256().begin()),
+        mw::Hash(InsecureRand256().begin()),
+        mw::Hash(InsecureRand256().begin()),
+        BlindingFactor(InsecureRand256().begin()),
+        BlindingFactor(InsecureRand256().begin()),
+        height,
+        height);
+}
+
+BOOST_AUTO_TEST_CASE(load_block_index_without_mweb_headers)
+{
+    // Build a chain in which every other block has MWEB data
+    std::vector<uint256> hashes(10000);
+    std::vector<CBlockIndex> entries(hashes.size());
+    std::vector<const CBlockIndex*> blockinfo;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        CBlockIndex& entry = entries[i];
+        entry.pprev = i > 0 ? &entries[i - 1] : nullptr;
+        entry.nHeight = i;
+        entry.nBits = 0x207fffff;
+        entry.nNonce = InsecureRand32();
+        // Entries are keyed by the hash of their header when they're loaded
+        hashes[i] = entry.GetBlockHeader().GetHash();
+        entry.phashBlock = &hashes[i];
+        entry.nTx = 1;
+        entry.nStatus = BLOCK_VALID_TREE;
+        if (i % 2) {
+            entry.nStatus |= BLOCK_HAVE_MWEB;
+            entry.mweb_header = BuildMWEBHeader(i);
+            entry.mweb_amount = i;
+        }
+        blockinfo.push_back(&entry);
+    }
+
+    CBlockTreeDB blocktree(1 << 20, /* fMemory */ true);
+    BOOST_REQUIRE(blocktree.WriteBatchSync({}, 0, blockinfo));
+
+    LOCK(cs_main);
+    {
+        BlockManager blockman;
+        std::set<CBlockIndex*, CBlockIndexWorkComparator> candidates;
+        BOOST_REQUIRE(blockman.LoadBlockIndex(Params().GetConsensus(), blocktree, candidates));
+        BOOST_REQUIRE_EQUAL(blockman.m_block_index.size(), entries.size());
+        BOOST_CHECK(blockman.DynamicMemoryUsage() >= entries.size() * sizeof(CBlockIndex));
+
+        std::vector<const CBlockIndex*> loaded;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const CBlockIndex* pindex = blockman.m_block_index.at(hashes[i]);
+            BOOST_CHECK_EQUAL(pindex->nHeight, entries[i].nHeight);
+            BOOST_CHECK_EQUAL(pindex->mweb_amount, entries[i].mweb_amount);
+            BOOST_CHECK(pindex->pprev == (i > 0 ? loaded.back() : nullptr));
+
+            // MWEB headers are left in the database until they're needed
+            BOOST_CHECK(pindex->mweb_header == nullptr);
+            const mw::Header::CPtr header = blocktree.ReadMWEBHeader(hashes[i]);
+            BOOST_CHECK((header == nullptr) == (entries[i].mweb_header == nullptr));
+            if (header != nullptr) {
+                BOOST_CHECK(*header == *entries[i].mweb_header);
+            }
+            loaded.push_back(pindex);
+        }
+
+        // Rewriting loaded entries keeps their MWEB headers
+        BOOST_REQUIRE(blocktree.WriteBatchSync({}, 0, loaded));
+        for (size_t i = 1; i < entries.size(); i += 2) {
+            const mw::Header::CPtr header = blocktree.ReadMWEBHeader(hashes[i]);
+            BOOST_REQUIRE(header != nullptr);
+            BOOST_CHECK(*header == *entries[i].mweb_header);
+        }
+    }
+    pindexBestHeader = nullptr;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blocktranscoder.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <version.h>
+
+#include <mw/consensus/Aggregation.h>
+#include <test_framework/TxBuilder.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blocktranscoder_tests, BasicTestingSetup)
+
+static std::vector<uint8_t> SerializeBlock(const CBlock& block, int flags)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION | flags);
+    stream << block;
+    return std::vector<uint8_t>(stream.begin(), stream.end());
+}
+
+static CBlock BuildBlock(bool with_mweb)
+{
+    CBlock block;
+    block.nVersion = 1;
+    block.hashPrevBlock = InsecureRand256();
+    block.hashMerkleRoot = InsecureRand256();
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig.resize(10);
+    coinbase.vin[0].scriptWitness.stack.resize(1, std::vector<unsigned char>(32, 0x42));
+    coinbase.vout.resize(2);
+    coinbase.vout[0].nValue = 42;
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+
+    CMutableTransaction tx;
+    tx.vin.resize(3);
+    for (CTxIn& txin : tx.vin) {
+        txin.prevout = COutPoint(InsecureRand256(), InsecureRandBits(4));
+        txin.scriptSig.resize(InsecureRandRange(100));
+    }
+    tx.vin[1].scriptWitness.stack = {{1, 2, 3}, {}, std::vector<unsigned char>(300, 7)};
+    tx.vout.resize(2);
+    tx.vout[1].scriptPubKey.resize(300);
+    tx.nLockTime = 1234;
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    // A transaction without witnesses, in the basic serialization format.
+    tx.vin.resize(1);
+    tx.vin[0].scriptWitness.SetNull();
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    if (with_mweb) {
+        CMutableTransaction hogex;
+        hogex.vin.resize(1);
+        hogex.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+        hogex.vout.resize(1);
+        hogex.vout[0].nValue = 10;
+        hogex.m_hogEx = true;
+        block.vtx.push_back(MakeTransactionRef(hogex));
+
+        test::Tx mweb_tx = test::TxBuilder().AddPeginKernel(10).AddOutput(10).Build();
+        mw::Transaction::CPtr pAggregated = Aggregation::Aggregate({mweb_tx.GetTransaction()});
+        mw::Header::CPtr pHeader = std::make_shared<mw::Header>(
+            1,
+            mw::Hash(InsecureRand256().begin()),
+            mw::Hash(InsecureRand256().begin()),
+            mw::Hash(InsecureRand256().begin()),
+            BlindingFactor(pAggregated->GetKernelOffset()),
+            BlindingFactor(pAggregated->GetStealthOffset()),
+            pAggregated->GetOutputs().size(),
+            pAggregated->GetKernels().size()
+        );
+        block.mweb_block = MWEB::Block(std::make_shared<mw::Block>(pHeader, pAggregated->GetBody()));
+    }
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(transcode_matches_serialization)
+{
+    for (const bool with_mweb : {false, true}) {
+        const CBlock block = BuildBlock(with_mweb);
+        const std::vector<uint8_t> full = SerializeBlock(block, 0);
+        for (const int flags : {0, SERIALIZE_NO_MWEB, SERIALIZE_TRANSACTION_NO_WITNESS, SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB}) {
+            std::vector<uint8_t> transcoded;
+            BOOST_CHECK(TranscodeBlock(full, flags, transcoded));
+            BOOST_CHECK(transcoded == SerializeBlock(block, flags));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transcode_rejects_unsupported)
+{
+    const std::vector<uint8_t> full = SerializeBlock(BuildBlock(true), 0);
+    std::vector<uint8_t> transcoded;
+
+    // Truncated blocks are rejected.
+    const std::vector<uint8_t> truncated(full.begin(), full.begin() + full.size() / 2);
+    BOOST_CHECK(!TranscodeBlock(truncated, SERIALIZE_NO_MWEB, transcoded));
+
+    // Transactions carrying MWEB transaction data are left to the deserializer.
+    CBlock block = BuildBlock(false);
+    CMutableTransaction tx(*block.vtx[1]);
+    tx.mweb_tx = MWEB::Tx(test::TxBuilder().AddPeginKernel(10).AddOutput(10).Build().GetTransaction());
+    block.vtx[1] = MakeTransactionRef(tx);
+    BOOST_CHECK(!TranscodeBlock(SerializeBlock(block, 0), SERIALIZE_NO_MWEB, transcoded));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <attributes.h>
 #include <clientversion.h>
 #include <coins.h>
+#include <coinsprefetch.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
@@ -13,6 +14,7 @@
 #include <undo.h>
 #include <util/strencodings.h>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -64,7 +66,7 @@ public:
 
     uint256 GetBestBlock() const override { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const mw::CoinsViewCache::Ptr& mweb_view) override
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, const mw::CoinsViewCache::Ptr& mweb_view, bool erase) override
     {
         for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
             if (it->second.flags & CCoinsCacheEntry::DIRTY) {
@@ -75,7 +77,11 @@ public:
                     map_.erase(it->first);
                 }
             }
-            mapCoins.erase(it++);
+            if (erase) {
+                mapCoins.erase(it++);
+            } else {
+                ++it;
+            }
         }
         if (!hashBlock.IsNull())
             hashBestBlock_ = hashBlock;
@@ -629,9 +635,10 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, const mw::CoinsViewCache::Ptr& mweb_view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map(0, CCoinsMap::hasher(), CCoinsMap::key_equal(), &resource);
     InsertCoinsMapEntry(map, value, flags);
-    BOOST_CHECK(view.BatchWrite(map, {}, mweb_view));
+    BOOST_CHECK(view.BatchWrite(map, {}, mweb_view, /* erase */ true));
 }
 
 class SingleEntryCacheTest
@@ -913,4 +920,155 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch)
+{
+    CCoinsViewTest base;
+    const COutPoint outpoint(InsecureRand256(), 0);
+    const COutPoint missing(InsecureRand256(), 0);
+    Coin coin;
+    coin.out.nValue = InsecureRand32();
+    coin.nHeight = 1;
+    {
+        CCoinsViewCacheTest cache(&base);
+        cache.AddCoin(outpoint, Coin(coin), false);
+        BOOST_CHECK(cache.Flush());
+    }
+
+    CCoinsViewPrefetch prefetch(&base);
+    prefetch.Prefetch(base, {outpoint, missing});
+    BOOST_CHECK_EQUAL(prefetch.GetPrefetchedCount(), 1U);
+
+    // A prefetched coin is handed out once, after which the cache above holds it.
+    {
+        CCoinsViewCacheTest cache(&prefetch);
+        BOOST_CHECK(cache.AccessCoin(outpoint) == coin);
+        BOOST_CHECK(!cache.HaveCoin(missing));
+        BOOST_CHECK_EQUAL(prefetch.GetPrefetchedCount(), 0U);
+    }
+
+    // Flushing through the view drops everything prefetched, since the database may have changed.
+    prefetch.Prefetch(base, {outpoint});
+    BOOST_CHECK_EQUAL(prefetch.GetPrefetchedCount(), 1U);
+    {
+        CCoinsViewCacheTest cache(&prefetch);
+        BOOST_CHECK(cache.SpendCoin(outpoint));
+        BOOST_CHECK(cache.Flush());
+        BOOST_CHECK_EQUAL(prefetch.GetPrefetchedCount(), 0U);
+    }
+
+    CCoinsViewCacheTest cache(&prefetch);
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_sync)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    const COutPoint kept(InsecureRand256(), 0);
+    const COutPoint spent(InsecureRand256(), 0);
+    Coin coin;
+    coin.out.nValue = InsecureRand32();
+    coin.nHeight = 1;
+    cache.AddCoin(kept, Coin(coin), false);
+    cache.AddCoin(spent, Coin(coin), false);
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Sync());
+
+    // Both coins reached the base, and the unspent ones stay cached, but clean.
+    BOOST_CHECK(base.HaveCoin(kept));
+    BOOST_CHECK(base.HaveCoin(spent));
+    BOOST_CHECK_EQUAL(base.GetBestBlock(), cache.GetBestBlock());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 2U);
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    }
+    cache.SelfTest();
+
+    // Spending a coin and syncing again erases it from the base, and drops it from the cache.
+    BOOST_CHECK(cache.SpendCoin(spent));
+    BOOST_CHECK(cache.Sync());
+    Coin base_coin;
+    BOOST_CHECK(!base.GetCoin(spent, base_coin) || base_coin.IsSpent());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 1U);
+    BOOST_CHECK(cache.AccessCoin(kept) == coin);
+    cache.SelfTest();
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_db_shards)
+{
+    const fs::path path = GetDataDir() / "chainstate_shards";
+    auto open_db = [&](int shards) {
+        auto db = MakeUnique<CCoinsViewDB>(path, 1 << 20, /* fMemory */ false, /* fWipe */ false, shards);
+        db->SetMWEBView(mw::CoinsViewDB::Open(FilePath{GetDataDir()}, {nullptr}, nullptr));
+        return db;
+    };
+    auto read_all = [](const CCoinsViewDB& db) {
+        std::vector<std::pair<COutPoint, CAmount>> coins;
+        std::unique_ptr<CCoinsViewCursor> cursor(db.Cursor());
+        for (; cursor->Valid(); cursor->Next()) {
+            COutPoint key;
+            Coin coin;
+            BOOST_CHECK(cursor->GetKey(key));
+            BOOST_CHECK(cursor->GetValue(coin));
+            coins.emplace_back(key, coin.out.nValue);
+        }
+        return coins;
+    };
+
+    // A fresh database adopts the requested layout right away.
+    std::vector<COutPoint> outpoints;
+    std::vector<std::pair<COutPoint, CAmount>> expected;
+    {
+        auto db = open_db(1);
+        BOOST_CHECK_EQUAL(db->GetShardCount(), 1);
+        CCoinsViewCache cache(db.get());
+        for (int i = 0; i < 1000; ++i) {
+            outpoints.emplace_back(InsecureRand256(), InsecureRandRange(4));
+            Coin coin;
+            coin.out.nValue = InsecureRandRange(1000000) + 1;
+            coin.nHeight = 1;
+            cache.AddCoin(outpoints.back(), std::move(coin), false);
+        }
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(cache.Flush());
+        expected = read_all(*db);
+        BOOST_CHECK_EQUAL(expected.size(), outpoints.size());
+    }
+
+    // Migrate to several shards. The coins and their iteration order are unchanged.
+    {
+        auto db = open_db(4);
+        BOOST_CHECK_EQUAL(db->GetShardCount(), 1);
+        BOOST_CHECK(db->Reshard());
+        BOOST_CHECK_EQUAL(db->GetShardCount(), 4);
+        BOOST_CHECK(fs::is_directory(path / "shards_4"));
+        BOOST_CHECK(read_all(*db) == expected);
+
+        // Writes go to the shards.
+        CCoinsViewCache cache(db.get());
+        BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+        cache.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(cache.Flush());
+        BOOST_CHECK(!db->HaveCoin(outpoints[0]));
+        BOOST_CHECK(db->HaveCoin(outpoints[1]));
+        expected.erase(std::find_if(expected.begin(), expected.end(), [&](const std::pair<COutPoint, CAmount>& entry) { return entry.first == outpoints[0]; }));
+        BOOST_CHECK(read_all(*db) == expected);
+    }
+
+    // Reopening with the same number of shards picks up where it left off, and migrating back removes them.
+    {
+        auto db = open_db(4);
+        BOOST_CHECK_EQUAL(db->GetShardCount(), 4);
+        BOOST_CHECK(db->Reshard());
+        BOOST_CHECK(read_all(*db) == expected);
+    }
+    {
+        auto db = open_db(1);
+        BOOST_CHECK(db->Reshard());
+        BOOST_CHECK_EQUAL(db->GetShardCount(), 1);
+        BOOST_CHECK(!fs::exists(path / "shards_4"));
+        BOOST_CHECK(read_all(*db) == expected);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 #include <boost/test/unit_test.hpp>
 #include <cuckoocache.h>
 #include <deque>
+#include <set>
 #include <random.h>
 #include <script/sigcache.h>
 #include <test/util/setup_common.h>
@@ -363,4 +364,28 @@ BOOST_AUTO_TEST_CASE(cuckoocache_generations)
     test_cache_generations<CuckooCache::cache<uint256, SignatureCacheHasher>>();
 }
 
+/* Test that for_each visits exactly the elements that haven't been erased.
+ */
+BOOST_AUTO_TEST_CASE(cuckoocache_for_each)
+{
+    SeedInsecureRand(SeedRand::ZEROS);
+    CuckooCache::cache<uint256, SignatureCacheHasher> cc{};
+    // Large enough that nothing is evicted
+    cc.setup_bytes(4 << 20);
+    std::set<uint256> expected;
+    for (int x = 0; x < 10000; ++x) {
+        const uint256 hash = InsecureRand256();
+        cc.insert(hash);
+        // Erase every other element
+        if (x % 2) {
+            BOOST_CHECK(cc.contains(hash, true));
+        } else {
+            expected.insert(hash);
+        }
+    }
+    std::set<uint256> visited;
+    cc.for_each([&](const uint256& hash) { BOOST_CHECK(visited.insert(hash).second); });
+    BOOST_CHECK(visited == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END();